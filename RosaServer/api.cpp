@@ -1,7 +1,20 @@
 #include "api.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
+#include <limits>
+#include "batch.h"
+#include "bonehistory.h"
 #include "console.h"
+#include "flightrecorder.h"
+#include "httpclient.h"
+#include "httpserver.h"
+#include "logger.h"
+#include "luaerrors.h"
+#include "serialize.h"
+#include "webhook.h"
 
 bool initialized = false;
 bool shouldReset = false;
@@ -20,20 +33,70 @@ std::mutex stateResetMutex;
 static constexpr const char* errorOutOfRange = "Index out of range";
 static constexpr const char* missingArgument = "Missing argument";
 
-void printLuaError(sol::error* err) {
-	std::ostringstream stream;
+static std::atomic_uint64_t numLuaErrors(0);
+
+uint64_t getNumLuaErrors() { return numLuaErrors; }
+
+void printLuaError(sol::error* err, const char* event) {
+	numLuaErrors++;
+	LuaErrors::report(err->what(), event);
+}
+
+class RosaSerializeCodec : public Serialize::Codec {
+	enum : uint8_t { typeVector, typeRotMatrix };
+
+ public:
+	bool encode(lua_State* L, int index, std::string& out) const override {
+		if (sol::stack::check<Vector>(L, index, sol::no_panic)) {
+			const Vector* vec = sol::stack::get<Vector*>(L, index);
+			const float values[] = {vec->x, vec->y, vec->z};
+			out.push_back(typeVector);
+			Serialize::write(out, values, sizeof(values));
+			return true;
+		}
+
+		if (sol::stack::check<RotMatrix>(L, index, sol::no_panic)) {
+			const RotMatrix* rot = sol::stack::get<RotMatrix*>(L, index);
+			const float values[] = {rot->x1, rot->y1, rot->z1, rot->x2, rot->y2,
+			                        rot->z2, rot->x3, rot->y3, rot->z3};
+			out.push_back(typeRotMatrix);
+			Serialize::write(out, values, sizeof(values));
+			return true;
+		}
+
+		return false;
+	}
+
+	bool decode(lua_State* L, uint8_t type,
+	            Serialize::Reader& reader) const override {
+		if (type == typeVector) {
+			float v[3];
+			reader.read(v, sizeof(v));
+			sol::stack::push(L, Vector{v[0], v[1], v[2]});
+			return true;
+		}
+
+		if (type == typeRotMatrix) {
+			float r[9];
+			reader.read(r, sizeof(r));
+			sol::stack::push(
+			    L, RotMatrix{r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8]});
+			return true;
+		}
 
-	stream << "\033[41;1m Lua error \033[0m\n\033[31m";
-	stream << err->what();
-	stream << "\033[0m\n";
+		return false;
+	}
+};
 
-	Console::log(stream.str());
+const Serialize::Codec* getSerializeCodec() {
+	static const RosaSerializeCodec codec;
+	return &codec;
 }
 
-bool noLuaCallError(sol::protected_function_result* res) {
+bool noLuaCallError(sol::protected_function_result* res, const char* event) {
 	if (res->valid()) return true;
 	sol::error err = *res;
-	printLuaError(&err);
+	printLuaError(&err, event);
 	return false;
 }
 
@@ -64,12 +127,15 @@ void hookAndReset(int reason) {
 }
 
 namespace Lua {
-void print(sol::variadic_args args, sol::this_state s) {
+// Joins the arguments with tabs like print, returns false if one couldn't be
+// converted
+static bool formatPrint(sol::variadic_args args, sol::this_state s,
+                        std::string& line) {
 	sol::state_view lua(s);
 
 	sol::protected_function toString = lua["tostring"];
 	if (toString == sol::nil) {
-		return;
+		return false;
 	}
 
 	std::ostringstream stream;
@@ -84,7 +150,7 @@ void print(sol::variadic_args args, sol::this_state s) {
 		auto stringified = toString(arg);
 
 		if (!noLuaCallError(&stringified)) {
-			return;
+			return false;
 		}
 
 		std::string str = stringified;
@@ -93,7 +159,13 @@ void print(sol::variadic_args args, sol::this_state s) {
 
 	stream << '\n';
 
-	Console::log(stream.str());
+	line = stream.str();
+	return true;
+}
+
+void print(sol::variadic_args args, sol::this_state s) {
+	std::string line;
+	if (formatPrint(args, s, line)) Logger::log(Logger::levelInfo, line);
 }
 
 void flagStateForReset(const char* mode) {
@@ -135,39 +207,305 @@ static sol::object handleSyncHTTPResponse(httplib::Result& res,
 	return sol::make_object(lua, sol::lua_nil);
 }
 
-sol::object http::getSync(const char* scheme, const char* path,
-                          sol::table headers, sol::this_state s) {
-	httplib::Client client(scheme);
-	client.set_connection_timeout(6);
-	client.set_keep_alive(false);
-
+static httplib::Headers headersFromTable(sol::table headers) {
 	httplib::Headers httpHeaders;
 	for (const auto& pair : headers)
 		httpHeaders.emplace(pair.first.as<std::string>(),
 		                    pair.second.as<std::string>());
+	return httpHeaders;
+}
+
+void http::get(const char* scheme, const char* path, sol::table headers,
+               sol::protected_function callback) {
+	LuaHTTPRequest request;
+	request.type = LuaRequestType::get;
+	request.scheme = scheme;
+	request.path = path;
+	request.headers = headersFromTable(headers);
+
+	HTTPClient::enqueue(std::move(request), callback);
+}
+
+void http::post(const char* scheme, const char* path, sol::table headers,
+                std::string body, const char* contentType,
+                sol::protected_function callback) {
+	LuaHTTPRequest request;
+	request.type = LuaRequestType::post;
+	request.scheme = scheme;
+	request.path = path;
+	request.headers = headersFromTable(headers);
+	request.body = std::move(body);
+	request.contentType = contentType;
+
+	HTTPClient::enqueue(std::move(request), callback);
+}
+
+void http::download(const char* url, const char* path,
+                    sol::protected_function callback) {
+	LuaHTTPRequest request;
+	request.type = LuaRequestType::download;
+	HTTPClient::splitURL(url, request.scheme, request.path);
+	request.filePath = path;
+
+	HTTPClient::enqueue(std::move(request), callback);
+}
+
+void http::upload(const char* path, const char* url,
+                  sol::protected_function callback) {
+	LuaHTTPRequest request;
+	request.type = LuaRequestType::upload;
+	HTTPClient::splitURL(url, request.scheme, request.path);
+	request.filePath = path;
+	request.contentType = "application/octet-stream";
+
+	HTTPClient::enqueue(std::move(request), callback);
+}
+
+void http::setCallbackBudget(unsigned int budget) {
+	HTTPClient::setCallbackBudget(budget);
+}
+
+void http::setMaxInFlight(unsigned int max) { HTTPClient::setMaxInFlight(max); }
+
+unsigned int http::getNumInFlight() { return HTTPClient::getNumInFlight(); }
 
-	httpHeaders.emplace("Connection", "close");
+sol::object http::getSync(const char* scheme, const char* path,
+                          sol::table headers, sol::this_state s) {
+	LuaHTTPRequest request;
+	request.type = LuaRequestType::get;
+	request.scheme = scheme;
+	request.path = path;
+	request.headers = headersFromTable(headers);
 
-	auto res = client.Get(path, httpHeaders);
+	auto res = HTTPClient::performSync(request);
 	return handleSyncHTTPResponse(res, s);
 }
 
 sol::object http::postSync(const char* scheme, const char* path,
                            sol::table headers, std::string body,
                            const char* contentType, sol::this_state s) {
-	httplib::Client client(scheme);
-	client.set_connection_timeout(6);
-	client.set_keep_alive(false);
+	LuaHTTPRequest request;
+	request.type = LuaRequestType::post;
+	request.scheme = scheme;
+	request.path = path;
+	request.headers = headersFromTable(headers);
+	request.body = std::move(body);
+	request.contentType = contentType;
+
+	auto res = HTTPClient::performSync(request);
+	return handleSyncHTTPResponse(res, s);
+}
 
-	httplib::Headers httpHeaders;
-	for (const auto& pair : headers)
-		httpHeaders.emplace(pair.first.as<std::string>(),
-		                    pair.second.as<std::string>());
+void http::setPoolLimits(unsigned int maxConnectionsPerHost,
+                         unsigned int idleTimeoutSeconds) {
+	HTTPClient::setPoolLimits(maxConnectionsPerHost, idleTimeoutSeconds);
+}
 
-	httpHeaders.emplace("Connection", "close");
+sol::table http::getPoolStats(sol::this_state s) {
+	sol::state_view lua(s);
+	auto stats = HTTPClient::getPoolStats();
+
+	sol::table table = lua.create_table();
+	table["hits"] = stats.hits;
+	table["misses"] = stats.misses;
+	table["evictions"] = stats.evictions;
+	table["idle"] = stats.idle;
+	table["active"] = stats.active;
+	return table;
+}
 
-	auto res = client.Post(path, httpHeaders, body, contentType);
-	return handleSyncHTTPResponse(res, s);
+static void logFormatted(Logger::Level level, sol::variadic_args args,
+                         sol::this_state s) {
+	std::string line;
+	if (formatPrint(args, s, line)) Logger::log(level, line);
+}
+
+void logger::debug(sol::variadic_args args, sol::this_state s) {
+	logFormatted(Logger::levelDebug, args, s);
+}
+
+void logger::info(sol::variadic_args args, sol::this_state s) {
+	logFormatted(Logger::levelInfo, args, s);
+}
+
+void logger::warning(sol::variadic_args args, sol::this_state s) {
+	logFormatted(Logger::levelWarning, args, s);
+}
+
+void logger::error(sol::variadic_args args, sol::this_state s) {
+	logFormatted(Logger::levelError, args, s);
+}
+
+std::string logger::getConsoleLevel() {
+	return Logger::getLevelName(Logger::getConsoleLevel());
+}
+
+void logger::setConsoleLevel(std::string level) {
+	Logger::setConsoleLevel(Logger::parseLevel(level));
+}
+
+void logger::openFile(std::string path, sol::optional<sol::table> options) {
+	Logger::FileOptions fileOptions;
+	if (options) {
+		fileOptions.maxBytes = options->get_or("maxBytes", fileOptions.maxBytes);
+		fileOptions.maxFiles = options->get_or("maxFiles", fileOptions.maxFiles);
+		sol::optional<std::string> level = (*options)["level"];
+		if (level) fileOptions.level = Logger::parseLevel(*level);
+	}
+
+	Logger::openFile(path, fileOptions);
+}
+
+void logger::closeFile() { Logger::closeFile(); }
+
+bool logger::flush(sol::optional<int> timeoutMs) {
+	return Logger::flush(timeoutMs.value_or(1000));
+}
+
+sol::table logger::getStats(sol::this_state s) {
+	sol::state_view lua(s);
+
+	auto stats = Logger::getStats();
+	sol::table table = lua.create_table();
+	table["queued"] = stats.queued;
+	table["capacity"] = stats.capacity;
+	table["logged"] = stats.logged;
+	table["written"] = stats.written;
+	table["dropped"] = stats.dropped;
+	table["rotations"] = stats.rotations;
+
+	sol::table droppedByLevel = lua.create_table();
+	for (int i = 0; i < Logger::numLevels; i++) {
+		droppedByLevel[Logger::getLevelName(static_cast<Logger::Level>(i))] =
+		    stats.droppedByLevel[i];
+	}
+	table["droppedByLevel"] = droppedByLevel;
+	return table;
+}
+
+void luaErrors::configure(sol::table options) {
+	auto current = LuaErrors::getOptions();
+
+	// Read as doubles so negative counts are caught rather than wrapping
+	double burst = options.get_or<double>("burst", current.burst);
+	double disableThreshold =
+	    options.get_or<double>("disableThreshold", current.disableThreshold);
+	current.perSecond = options.get_or("perSecond", current.perSecond);
+	current.disableWindowSeconds =
+	    options.get_or("disableWindowSeconds", current.disableWindowSeconds);
+
+	// A burst under 1 would hold back every error for good
+	constexpr double maxCount = std::numeric_limits<unsigned int>::max();
+	if (!(burst >= 1 && burst <= maxCount) ||
+	    !(disableThreshold >= 0 && disableThreshold <= maxCount) ||
+	    !(current.perSecond >= 0) || !(current.disableWindowSeconds >= 0))
+		throw std::invalid_argument(errorOutOfRange);
+
+	current.burst = burst;
+	current.disableThreshold = disableThreshold;
+	LuaErrors::setOptions(current);
+}
+
+sol::table luaErrors::getStats(sol::this_state s) {
+	sol::state_view lua(s);
+
+	auto stats = LuaErrors::getStats();
+	sol::table table = lua.create_table();
+	table["errors"] = stats.errors;
+	table["printed"] = stats.printed;
+	table["suppressed"] = stats.suppressed;
+	table["fingerprints"] = stats.numFingerprints;
+
+	sol::table disabledEvents = lua.create_table();
+	for (size_t i = 0; i < stats.disabledEvents.size(); i++)
+		disabledEvents[i + 1] = stats.disabledEvents[i];
+	table["disabledEvents"] = disabledEvents;
+	return table;
+}
+
+sol::table luaErrors::getFingerprints(sol::this_state s) {
+	sol::state_view lua(s);
+
+	auto fingerprints = LuaErrors::getFingerprints();
+	sol::table list = lua.create_table(fingerprints.size());
+	for (size_t i = 0; i < fingerprints.size(); i++) {
+		sol::table entry = lua.create_table();
+		entry["message"] = fingerprints[i].message;
+		entry["count"] = fingerprints[i].count;
+		entry["suppressed"] = fingerprints[i].suppressed;
+		list[i + 1] = entry;
+	}
+	return list;
+}
+
+void luaErrors::enableEvent(std::string event) {
+	LuaErrors::enableEvent(event);
+}
+
+void flightRecorder::dump(const char* path) {
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1) throw std::runtime_error(strerror(errno));
+
+	FlightRecorder::dump(fd);
+	close(fd);
+}
+
+sol::table flightRecorder::getRecent(size_t count, sol::this_state s) {
+	sol::state_view lua(s);
+
+	auto entries = FlightRecorder::getRecent(count);
+	sol::table list = lua.create_table(entries.size());
+	for (size_t i = 0; i < entries.size(); i++) {
+		auto& entry = entries[i];
+		sol::table table = lua.create_table();
+		table["event"] = entry.event;
+		if (entry.entity >= 0) table["entity"] = entry.entity;
+		table["tick"] = entry.tick;
+		table["secondsAgo"] = entry.secondsAgo;
+		// Left out while the dispatch is still running
+		if (entry.durationSeconds >= 0)
+			table["durationSeconds"] = entry.durationSeconds;
+		list[i + 1] = table;
+	}
+	return list;
+}
+
+bool webhook::enqueue(const char* url, std::string body) {
+	return Webhook::enqueue(url, std::move(body));
+}
+
+void webhook::configure(const char* url, sol::table options) {
+	auto current = Webhook::getOptions(url);
+
+	current.maxBatchMessages =
+	    options.get_or("maxBatchMessages", current.maxBatchMessages);
+	current.maxBatchBytes = options.get_or("maxBatchBytes", current.maxBatchBytes);
+	current.flushMs = options.get_or("flushMs", current.flushMs);
+	current.maxQueuedBytes =
+	    options.get_or("maxQueuedBytes", current.maxQueuedBytes);
+	current.maxRetries = options.get_or("maxRetries", current.maxRetries);
+	current.prefix = options.get_or("prefix", current.prefix);
+	current.separator = options.get_or("separator", current.separator);
+	current.suffix = options.get_or("suffix", current.suffix);
+	current.contentType = options.get_or("contentType", current.contentType);
+
+	Webhook::setOptions(url, current);
+}
+
+sol::object webhook::getStats(const char* url, sol::this_state s) {
+	sol::state_view lua(s);
+
+	Webhook::Stats stats;
+	if (!Webhook::getStats(url, stats)) return sol::make_object(lua, sol::lua_nil);
+
+	sol::table table = lua.create_table();
+	table["queued"] = stats.queued;
+	table["queuedBytes"] = stats.queuedBytes;
+	table["sent"] = stats.sent;
+	table["failed"] = stats.failed;
+	table["dropped"] = stats.dropped;
+	table["retries"] = stats.retries;
+	return sol::make_object(lua, table);
 }
 
 void event::sound(int soundType, Vector* pos, float volume, float pitch) {
@@ -220,6 +558,35 @@ sol::table physics::lineIntersectHuman(Human* man, Vector* posA, Vector* posB) {
 	return table;
 }
 
+sol::table physics::lineIntersectHumanAt(Human* man, Vector* posA,
+                                         Vector* posB, unsigned int ticksAgo) {
+	sol::table table = lua->create_table();
+	int humanID = man->getIndex();
+
+	BoneHistory::Frame current;
+	if (!BoneHistory::rewind(humanID, ticksAgo, &current)) {
+		// It didn't exist back then, so there's nothing to hit
+		table["hit"] = false;
+		return table;
+	}
+
+	int res;
+	{
+		subhook::ScopedHookRemove remove(&Hooks::lineIntersectHumanHook);
+		res = Engine::lineIntersectHuman(humanID, posA, posB);
+	}
+	BoneHistory::restore(humanID, &current);
+
+	if (res) {
+		table["pos"] = Engine::lineIntersectResult->pos;
+		table["normal"] = Engine::lineIntersectResult->normal;
+		table["fraction"] = Engine::lineIntersectResult->fraction;
+		table["bone"] = Engine::lineIntersectResult->humanBone;
+	}
+	table["hit"] = res != 0;
+	return table;
+}
+
 sol::table physics::lineIntersectVehicle(Vehicle* vcl, Vector* posA,
                                          Vector* posB) {
 	sol::table table = lua->create_table();
@@ -254,6 +621,144 @@ sol::object physics::lineIntersectTriangle(Vector* outPos, Vector* normal,
 
 void physics::garbageCollectBullets() { Engine::bulletTimeToLive(); }
 
+static std::vector<Vector*> batchPositions;
+static std::vector<Vector*> batchVelocities;
+static std::vector<RotMatrix*> batchOrientations;
+
+template <typename T>
+static void removeDuplicates(std::vector<T*>& pointers) {
+	std::sort(pointers.begin(), pointers.end());
+	pointers.erase(std::unique(pointers.begin(), pointers.end()), pointers.end());
+}
+
+// Collects every bone of the given humans and every particle of the given
+// vehicles, so the kernels can run over all of them in one pass. Anything
+// listed twice is only transformed once.
+static void gatherBatch(sol::table objects) {
+	batchPositions.clear();
+	batchVelocities.clear();
+	batchOrientations.clear();
+
+	for (const auto& pair : objects) {
+		sol::object object = pair.second;
+
+		if (object.is<Human>()) {
+			Human* man = object.as<Human*>();
+			for (int i = 0; i < 15; i++) {
+				batchPositions.push_back(&man->bones[i].pos);
+				batchPositions.push_back(&man->bones[i].pos2);
+				batchVelocities.push_back(&man->bones[i].vel);
+				batchOrientations.push_back(&man->bones[i].rot);
+			}
+		} else if (object.is<Vehicle>()) {
+			Vehicle* vcl = object.as<Vehicle*>();
+			batchPositions.push_back(&vcl->pos);
+			batchPositions.push_back(&vcl->pos2);
+			batchVelocities.push_back(&vcl->vel);
+			batchOrientations.push_back(&vcl->rot);
+
+			for (int i = 0; i < vcl->numParticles; i++) {
+				Particle* particle = &Engine::particles[vcl->particles[i]];
+				batchPositions.push_back(&particle->pos);
+				batchPositions.push_back(&particle->pos2);
+				batchVelocities.push_back(&particle->vel);
+			}
+		} else {
+			throw std::invalid_argument("Expected a Human or Vehicle");
+		}
+	}
+
+	removeDuplicates(batchPositions);
+	removeDuplicates(batchVelocities);
+	removeDuplicates(batchOrientations);
+}
+
+static const Vector origin = {0.f, 0.f, 0.f};
+
+void physics::batchTranslate(sol::table objects, Vector* offset) {
+	if (!offset) throw std::invalid_argument(missingArgument);
+	gatherBatch(objects);
+	Batch::translate(batchPositions.data(), batchPositions.size(), offset);
+}
+
+void physics::batchRotate(sol::table objects, Vector* pivot, RotMatrix* rot) {
+	if (!pivot || !rot) throw std::invalid_argument(missingArgument);
+	gatherBatch(objects);
+	Batch::rotate(batchPositions.data(), batchPositions.size(), pivot, rot);
+	Batch::rotate(batchVelocities.data(), batchVelocities.size(), &origin, rot);
+	// Orientations map local to world as in local * rot, so the rotation goes
+	// on the outside
+	for (RotMatrix* orientation : batchOrientations)
+		*orientation = rot->__mul(orientation);
+}
+
+void physics::batchAddVelocity(sol::table objects, Vector* vel) {
+	if (!vel) throw std::invalid_argument(missingArgument);
+	gatherBatch(objects);
+	Batch::translate(batchVelocities.data(), batchVelocities.size(), vel);
+}
+
+void physics::batchScaleVelocity(sol::table objects, float factor) {
+	gatherBatch(objects);
+	Batch::scale(batchVelocities.data(), batchVelocities.size(), &origin,
+	             factor);
+}
+
+static constexpr unsigned int maxTrajectorySteps = 4096;
+// Reused between calls, readable through FFI via the returned address
+static Vector trajectorySamples[maxTrajectorySteps + 1];
+
+sol::table physics::predictTrajectory(Vector* pos, Vector* vel,
+                                      sol::optional<float> gravity,
+                                      sol::optional<unsigned int> steps,
+                                      sol::optional<float> dt) {
+	if (!pos || !vel) throw std::invalid_argument(missingArgument);
+
+	float g = gravity ? gravity.value() : *Engine::gravity;
+	unsigned int numSteps = steps ? steps.value() : 60;
+	float delta = dt ? dt.value() : 1.f;
+	if (numSteps > maxTrajectorySteps)
+		throw std::invalid_argument(errorOutOfRange);
+
+	Vector position = *pos;
+	Vector velocity = *vel;
+	trajectorySamples[0] = position;
+
+	sol::table table = lua->create_table();
+	bool hit = false;
+	unsigned int step = 0;
+
+	while (step < numSteps) {
+		velocity.y -= g * delta;
+		Vector next = {position.x + velocity.x * delta,
+		               position.y + velocity.y * delta,
+		               position.z + velocity.z * delta};
+		step++;
+
+		if (Engine::lineIntersectLevel(&position, &next)) {
+			hit = true;
+			trajectorySamples[step] = Engine::lineIntersectResult->pos;
+			table["pos"] = Engine::lineIntersectResult->pos;
+			table["normal"] = Engine::lineIntersectResult->normal;
+			table["fraction"] = Engine::lineIntersectResult->fraction;
+			table["step"] = step;
+			break;
+		}
+
+		trajectorySamples[step] = next;
+		position = next;
+	}
+
+	if (!hit) {
+		table["pos"] = position;
+	}
+	table["hit"] = hit;
+	table["vel"] = velocity;
+	table["count"] = step + 1;
+	table["samples"] = (uintptr_t)trajectorySamples;
+	return table;
+}
+
 int itemTypes::getCount() { return maxNumberOfItemTypes; }
 
 sol::table itemTypes::getAll() {
@@ -549,6 +1054,7 @@ Human* humans::create(Vector* pos, RotMatrix* rot, Player* ply) {
 		delete humanDataTables[humanID];
 		humanDataTables[humanID] = nullptr;
 	}
+	BoneHistory::forget(humanID);
 
 	auto man = &Engine::humans[humanID];
 	man->playerID = playerID;
@@ -691,9 +1197,28 @@ double os::realClock() {
 	return value.count() / 1000.;
 }
 
+std::string serialize::encode(sol::object value) {
+	return Serialize::encode(value, getSerializeCodec());
+}
+
+sol::object serialize::decode(const std::string& data, sol::this_state s) {
+	return Serialize::decode(s, data, getSerializeCodec());
+}
+
+std::unique_ptr<JobPool> jobs::pool(unsigned int numThreads,
+                                    std::string fileName) {
+	if (numThreads < 1 || numThreads > 64)
+		throw std::invalid_argument(errorOutOfRange);
+
+	return std::make_unique<JobPool>(numThreads, fileName);
+}
+
 void os::exit() { exitCode(EXIT_SUCCESS); }
 
 void os::exitCode(int code) {
+	HTTPServer::stop();
+	// Anything still queued would be lost
+	Logger::flush(1000);
 	Console::cleanup();
 	::exit(code);
 }
@@ -969,9 +1494,35 @@ void Vector::set(Vector* other) {
 
 void Vector::cross(Vector* other) {
 	if (!other) throw std::invalid_argument(missingArgument);
+	float oldX = x;
+	float oldY = y;
 	x = y * other->z - z * other->y;
-	y = z * other->x - x * other->z;
-	z = x * other->y - y * other->x;
+	y = z * other->x - oldX * other->z;
+	z = oldX * other->y - oldY * other->x;
+}
+
+void Vector::addScaled(Vector* other, float scalar) {
+	if (!other) throw std::invalid_argument(missingArgument);
+	x += other->x * scalar;
+	y += other->y * scalar;
+	z += other->z * scalar;
+}
+
+void Vector::lerpTo(Vector* other, float t) {
+	if (!other) throw std::invalid_argument(missingArgument);
+	x += (other->x - x) * t;
+	y += (other->y - y) * t;
+	z += (other->z - z) * t;
+}
+
+void Vector::rotateBy(RotMatrix* rot) {
+	if (!rot) throw std::invalid_argument(missingArgument);
+	*this = __mul_RotMatrix(rot);
+}
+
+void Vector::transformInto(RotMatrix* rot, Vector* out) const {
+	if (!rot || !out) throw std::invalid_argument(missingArgument);
+	*out = __mul_RotMatrix(rot);
 }
 
 Vector Vector::clone() const { return Vector{x, y, z}; }
@@ -1049,6 +1600,145 @@ void RotMatrix::set(RotMatrix* other) {
 	z3 = other->z3;
 }
 
+void RotMatrix::rotateBy(RotMatrix* other) {
+	if (!other) throw std::invalid_argument(missingArgument);
+	*this = __mul(other);
+}
+
+static void normalizeRow(float& x, float& y, float& z) {
+	float length = sqrt(x * x + y * y + z * z);
+	if (length == 0.f) return;
+	x /= length;
+	y /= length;
+	z /= length;
+}
+
+static void subtractProjection(float& x, float& y, float& z, float ax, float ay,
+                               float az) {
+	float dot = x * ax + y * ay + z * az;
+	x -= ax * dot;
+	y -= ay * dot;
+	z -= az * dot;
+}
+
+// Gram-Schmidt over the rows, keeping the forward row's direction
+void RotMatrix::orthonormalize() {
+	normalizeRow(x1, y1, z1);
+
+	subtractProjection(x2, y2, z2, x1, y1, z1);
+	normalizeRow(x2, y2, z2);
+
+	subtractProjection(x3, y3, z3, x1, y1, z1);
+	subtractProjection(x3, y3, z3, x2, y2, z2);
+	normalizeRow(x3, y3, z3);
+}
+
+// Same convention as eulerAnglesToRotMatrix in RosaServerCore
+void RotMatrix::fromEuler(float rotX, float rotY, float rotZ) {
+	float s1 = sin(rotX);
+	float s2 = sin(rotY);
+	float s3 = sin(rotZ);
+	float c1 = cos(rotX);
+	float c2 = cos(rotY);
+	float c3 = cos(rotZ);
+
+	x1 = c2 * c3;
+	y1 = -c2 * s3;
+	z1 = s2;
+
+	x2 = c1 * s3 + c3 * s1 * s2;
+	y2 = c1 * c3 - s1 * s2 * s3;
+	z2 = -c2 * s1;
+
+	x3 = s1 * s3 - c1 * c3 * s2;
+	y3 = c3 * s1 + c1 * s2 * s3;
+	z3 = c1 * c2;
+}
+
+struct Quaternion {
+	float w, x, y, z;
+};
+
+static Quaternion quaternionFromRotMatrix(const RotMatrix* m) {
+	Quaternion q;
+	float trace = m->x1 + m->y2 + m->z3;
+
+	if (trace > 0.f) {
+		float s = sqrt(trace + 1.f) * 2.f;
+		q.w = 0.25f * s;
+		q.x = (m->y3 - m->z2) / s;
+		q.y = (m->z1 - m->x3) / s;
+		q.z = (m->x2 - m->y1) / s;
+	} else if (m->x1 > m->y2 && m->x1 > m->z3) {
+		float s = sqrt(1.f + m->x1 - m->y2 - m->z3) * 2.f;
+		q.w = (m->y3 - m->z2) / s;
+		q.x = 0.25f * s;
+		q.y = (m->y1 + m->x2) / s;
+		q.z = (m->z1 + m->x3) / s;
+	} else if (m->y2 > m->z3) {
+		float s = sqrt(1.f + m->y2 - m->x1 - m->z3) * 2.f;
+		q.w = (m->z1 - m->x3) / s;
+		q.x = (m->y1 + m->x2) / s;
+		q.y = 0.25f * s;
+		q.z = (m->z2 + m->y3) / s;
+	} else {
+		float s = sqrt(1.f + m->z3 - m->x1 - m->y2) * 2.f;
+		q.w = (m->x2 - m->y1) / s;
+		q.x = (m->z1 + m->x3) / s;
+		q.y = (m->z2 + m->y3) / s;
+		q.z = 0.25f * s;
+	}
+
+	return q;
+}
+
+static void quaternionToRotMatrix(const Quaternion& q, RotMatrix* m) {
+	m->x1 = 1.f - 2.f * (q.y * q.y + q.z * q.z);
+	m->y1 = 2.f * (q.x * q.y - q.z * q.w);
+	m->z1 = 2.f * (q.x * q.z + q.y * q.w);
+
+	m->x2 = 2.f * (q.x * q.y + q.z * q.w);
+	m->y2 = 1.f - 2.f * (q.x * q.x + q.z * q.z);
+	m->z2 = 2.f * (q.y * q.z - q.x * q.w);
+
+	m->x3 = 2.f * (q.x * q.z - q.y * q.w);
+	m->y3 = 2.f * (q.y * q.z + q.x * q.w);
+	m->z3 = 1.f - 2.f * (q.x * q.x + q.y * q.y);
+}
+
+void RotMatrix::slerp(RotMatrix* other, float t) {
+	if (!other) throw std::invalid_argument(missingArgument);
+
+	Quaternion a = quaternionFromRotMatrix(this);
+	Quaternion b = quaternionFromRotMatrix(other);
+
+	float dot = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+	// Take the shorter path
+	if (dot < 0.f) {
+		b = {-b.w, -b.x, -b.y, -b.z};
+		dot = -dot;
+	}
+
+	float scaleA, scaleB;
+	if (dot > 0.9995f) {
+		// Close enough to lerp, and avoids dividing by ~0
+		scaleA = 1.f - t;
+		scaleB = t;
+	} else {
+		float theta = acos(dot);
+		float sinTheta = sin(theta);
+		scaleA = sin((1.f - t) * theta) / sinTheta;
+		scaleB = sin(t * theta) / sinTheta;
+	}
+
+	Quaternion q = {scaleA * a.w + scaleB * b.w, scaleA * a.x + scaleB * b.x,
+	                scaleA * a.y + scaleB * b.y, scaleA * a.z + scaleB * b.z};
+	float length = sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+	q = {q.w / length, q.x / length, q.y / length, q.z / length};
+
+	quaternionToRotMatrix(q, this);
+}
+
 RotMatrix RotMatrix::clone() const {
 	return RotMatrix{x1, y1, z1, x2, y2, z2, x3, y3, z3};
 }
@@ -1235,26 +1925,15 @@ void Human::update() const {
 }
 
 void Human::teleport(Vector* vec) {
-	float offX = vec->x - pos.x;
-	float offY = vec->y - pos.y;
-	float offZ = vec->z - pos.z;
+	if (!vec) throw std::invalid_argument(missingArgument);
+	Vector offset = {vec->x - pos.x, vec->y - pos.y, vec->z - pos.z};
 
-	Bone* bone;
-	//RigidBody* body;
+	Vector* positions[15 * 2];
 	for (int i = 0; i < 15; i++) {
-		bone = &bones[i];
-		bone->pos.x += offX;
-		bone->pos.y += offY;
-		bone->pos.z += offZ;
-		bone->pos2.x += offX;
-		bone->pos2.y += offY;
-		bone->pos2.z += offZ;
-
-		//body = &Engine::bodies[bone->bodyID];
-		//body->pos.x += offX;
-		//body->pos.y += offY;
-		//body->pos.z += offZ;
+		positions[i * 2] = &bones[i].pos;
+		positions[i * 2 + 1] = &bones[i].pos2;
 	}
+	Batch::translate(positions, 15 * 2, &offset);
 };
 
 void Human::speak(const char* message, int distance) const {
@@ -1299,18 +1978,19 @@ Human* Human::getLeftHandGrab() const {
 }
 
 void Human::setVelocity(Vector* vec) {
-    for (int i = 0; i < 15; i++) {
-        bones[i].vel.set(vec);
-    }
+	if (!vec) throw std::invalid_argument(missingArgument);
+	Vector* velocities[15];
+	for (int i = 0; i < 15; i++) velocities[i] = &bones[i].vel;
+	Batch::set(velocities, 15, vec);
 }
 
 void Human::addVelocity(Vector* vec) {
-    for (int i = 0; i < 15; i++) {
-        bones[i].vel.add(vec);
-    }
+	if (!vec) throw std::invalid_argument(missingArgument);
+	Vector* velocities[15];
+	for (int i = 0; i < 15; i++) velocities[i] = &bones[i].vel;
+	Batch::translate(velocities, 15, vec);
 }
 
-
 InventorySlot* Human::getInventorySlot(unsigned int idx) {
 	if (idx > 6) throw std::invalid_argument(errorOutOfRange);
 
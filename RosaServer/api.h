@@ -1,6 +1,7 @@
 #pragma once
 #include "engine.h"
 #include "hooks.h"
+#include "jobpool.h"
 #include "sol/sol.hpp"
 
 #include <memory>
@@ -33,30 +34,48 @@ extern sol::table* itemDataTables[maxNumberOfItems];
 extern sol::table* vehicleDataTables[maxNumberOfVehicles];
 extern sol::table* particleDataTables[maxNumberOfParticles];
 
-enum LuaRequestType { get, post };
+enum LuaRequestType { get, post, download, upload };
 
+// Callbacks never leave the tick thread; requests refer to them by ID
 struct LuaHTTPRequest {
 	LuaRequestType type;
 	std::string scheme;
 	std::string path;
-	std::shared_ptr<sol::protected_function> callback;
+	uint64_t callbackID;
 	std::string contentType;
 	std::string body;
 	httplib::Headers headers;
+	// Downloaded to or uploaded from
+	std::string filePath;
 };
 
 struct LuaHTTPResponse {
-	std::shared_ptr<sol::protected_function> callback;
+	uint64_t callbackID;
+	LuaRequestType type;
 	bool responded;
 	int status;
 	std::string body;
 	httplib::Headers headers;
+	// Transfers report progress more than once before they're done
+	bool done = true;
+	uint64_t transferred = 0;
+	uint64_t total = 0;
+	std::string error;
 };
 
 extern std::mutex stateResetMutex;
 
-void printLuaError(sol::error* err);
-bool noLuaCallError(sol::protected_function_result* res);
+namespace Serialize {
+class Codec;
+}
+
+void printLuaError(sol::error* err, const char* event = nullptr);
+uint64_t getNumLuaErrors();
+// Handles Vector and RotMatrix values
+const Serialize::Codec* getSerializeCodec();
+// Errors from hooks pass the event, so it can be disabled if it keeps failing
+bool noLuaCallError(sol::protected_function_result* res,
+                    const char* event = nullptr);
 bool noLuaCallError(sol::load_result* res);
 void hookAndReset(int reason);
 
@@ -79,13 +98,55 @@ void post(const char* scheme, const char* path, sol::table headers,
           std::string body, const char* contentType,
           sol::protected_function callback);
 
+void setCallbackBudget(unsigned int budget);
+void setMaxInFlight(unsigned int max);
+unsigned int getNumInFlight();
+void setPoolLimits(unsigned int maxConnectionsPerHost,
+                   unsigned int idleTimeoutSeconds);
+sol::table getPoolStats(sol::this_state s);
+
 sol::object getSync(const char* scheme, const char* path, sol::table headers,
                     sol::this_state s);
 sol::object postSync(const char* scheme, const char* path, sol::table headers,
                      std::string body, const char* contentType,
                      sol::this_state s);
+void download(const char* url, const char* path,
+              sol::protected_function callback);
+void upload(const char* path, const char* url,
+            sol::protected_function callback);
 };  // namespace http
 
+namespace logger {
+void debug(sol::variadic_args args, sol::this_state s);
+void info(sol::variadic_args args, sol::this_state s);
+void warning(sol::variadic_args args, sol::this_state s);
+void error(sol::variadic_args args, sol::this_state s);
+std::string getConsoleLevel();
+void setConsoleLevel(std::string level);
+void openFile(std::string path, sol::optional<sol::table> options);
+void closeFile();
+bool flush(sol::optional<int> timeoutMs);
+sol::table getStats(sol::this_state s);
+};  // namespace logger
+
+namespace luaErrors {
+void configure(sol::table options);
+sol::table getStats(sol::this_state s);
+sol::table getFingerprints(sol::this_state s);
+void enableEvent(std::string event);
+};  // namespace luaErrors
+
+namespace flightRecorder {
+void dump(const char* path);
+sol::table getRecent(size_t count, sol::this_state s);
+};  // namespace flightRecorder
+
+namespace webhook {
+bool enqueue(const char* url, std::string body);
+void configure(const char* url, sol::table options);
+sol::object getStats(const char* url, sol::this_state s);
+};  // namespace webhook
+
 namespace event {
 	void sound(int soundType, Vector* pos, float volume, float pitch);
 	void soundSimple(int soundType, Vector* pos);
@@ -97,9 +158,15 @@ namespace event {
 namespace physics {
 	sol::table lineIntersectLevel(Vector* posA, Vector* posB);
 	sol::table lineIntersectHuman(Human* man, Vector* posA, Vector* posB);
+	sol::table lineIntersectHumanAt(Human* man, Vector* posA, Vector* posB, unsigned int ticksAgo);
 	sol::table lineIntersectVehicle(Vehicle* vcl, Vector* posA, Vector* posB);
 	sol::object lineIntersectTriangle(Vector* outPos, Vector* normal, Vector* posA,Vector* posB, Vector* triA, Vector* triB, Vector* triC, sol::this_state s);
 	void garbageCollectBullets();
+	void batchTranslate(sol::table objects, Vector* offset);
+	void batchRotate(sol::table objects, Vector* pivot, RotMatrix* rot);
+	void batchAddVelocity(sol::table objects, Vector* vel);
+	void batchScaleVelocity(sol::table objects, float factor);
+	sol::table predictTrajectory(Vector* pos, Vector* vel, sol::optional<float> gravity, sol::optional<unsigned int> steps, sol::optional<float> dt);
 };  // namespace physics
 
 namespace itemTypes {
@@ -199,6 +266,15 @@ sol::table getAll();
 StreetIntersection* getByIndex(sol::table self, unsigned int idx);
 };  // namespace intersections
 
+namespace serialize {
+std::string encode(sol::object value);
+sol::object decode(const std::string& data, sol::this_state s);
+};  // namespace serialize
+
+namespace jobs {
+std::unique_ptr<JobPool> pool(unsigned int numThreads, std::string fileName);
+};  // namespace jobs
+
 namespace os {
 sol::table listDirectory(const char* path, sol::this_state s);
 bool createDirectory(const char* path);
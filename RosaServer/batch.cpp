@@ -0,0 +1,95 @@
+#include "batch.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+// Vectors are 12 bytes, so load and store as 8 + 4 to never touch the next
+// field in the struct. The fourth lane is always zero.
+static inline __m128 load(const Vector* vec) {
+	__m128 xy = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)vec);
+	return _mm_movelh_ps(xy, _mm_load_ss(&vec->z));
+}
+
+static inline void store(Vector* vec, __m128 value) {
+	_mm_storel_pi((__m64*)vec, value);
+	_mm_store_ss(&vec->z, _mm_movehl_ps(value, value));
+}
+
+void Batch::set(Vector** vectors, size_t count, const Vector* value) {
+	__m128 v = load(value);
+	for (size_t i = 0; i < count; i++) store(vectors[i], v);
+}
+
+void Batch::translate(Vector** vectors, size_t count, const Vector* offset) {
+	__m128 off = load(offset);
+	for (size_t i = 0; i < count; i++)
+		store(vectors[i], _mm_add_ps(load(vectors[i]), off));
+}
+
+void Batch::scale(Vector** vectors, size_t count, const Vector* pivot,
+                  float factor) {
+	__m128 p = load(pivot);
+	__m128 f = _mm_set1_ps(factor);
+	for (size_t i = 0; i < count; i++) {
+		__m128 relative = _mm_sub_ps(load(vectors[i]), p);
+		store(vectors[i], _mm_add_ps(_mm_mul_ps(relative, f), p));
+	}
+}
+
+void Batch::rotate(Vector** vectors, size_t count, const Vector* pivot,
+                   const RotMatrix* rot) {
+	__m128 p = load(pivot);
+	__m128 colX = _mm_setr_ps(rot->x1, rot->x2, rot->x3, 0.f);
+	__m128 colY = _mm_setr_ps(rot->y1, rot->y2, rot->y3, 0.f);
+	__m128 colZ = _mm_setr_ps(rot->z1, rot->z2, rot->z3, 0.f);
+
+	for (size_t i = 0; i < count; i++) {
+		__m128 v = _mm_sub_ps(load(vectors[i]), p);
+		__m128 x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+		__m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+		__m128 z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+		__m128 result = _mm_add_ps(
+		    _mm_add_ps(_mm_mul_ps(colX, x), _mm_mul_ps(colY, y)),
+		    _mm_mul_ps(colZ, z));
+		store(vectors[i], _mm_add_ps(result, p));
+	}
+}
+
+#else
+
+void Batch::set(Vector** vectors, size_t count, const Vector* value) {
+	for (size_t i = 0; i < count; i++) *vectors[i] = *value;
+}
+
+void Batch::translate(Vector** vectors, size_t count, const Vector* offset) {
+	for (size_t i = 0; i < count; i++) {
+		vectors[i]->x += offset->x;
+		vectors[i]->y += offset->y;
+		vectors[i]->z += offset->z;
+	}
+}
+
+void Batch::scale(Vector** vectors, size_t count, const Vector* pivot,
+                  float factor) {
+	for (size_t i = 0; i < count; i++) {
+		Vector* vec = vectors[i];
+		vec->x = pivot->x + (vec->x - pivot->x) * factor;
+		vec->y = pivot->y + (vec->y - pivot->y) * factor;
+		vec->z = pivot->z + (vec->z - pivot->z) * factor;
+	}
+}
+
+void Batch::rotate(Vector** vectors, size_t count, const Vector* pivot,
+                   const RotMatrix* rot) {
+	for (size_t i = 0; i < count; i++) {
+		Vector* vec = vectors[i];
+		float x = vec->x - pivot->x;
+		float y = vec->y - pivot->y;
+		float z = vec->z - pivot->z;
+		vec->x = pivot->x + rot->x1 * x + rot->y1 * y + rot->z1 * z;
+		vec->y = pivot->y + rot->x2 * x + rot->y2 * y + rot->z2 * z;
+		vec->z = pivot->z + rot->x3 * x + rot->y3 * y + rot->z3 * z;
+	}
+}
+
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include "structs.h"
+
+// Transforms over many vectors at once. They take pointers rather than a
+// packed array since bone and particle fields are strided through much
+// larger structs.
+namespace Batch {
+void set(Vector** vectors, size_t count, const Vector* value);
+void translate(Vector** vectors, size_t count, const Vector* offset);
+// Scales each vector's distance from the pivot
+void scale(Vector** vectors, size_t count, const Vector* pivot, float factor);
+// Rotates each vector around the pivot, as in vector * rot
+void rotate(Vector** vectors, size_t count, const Vector* pivot,
+            const RotMatrix* rot);
+}  // namespace Batch
@@ -0,0 +1,59 @@
+#include "bonehistory.h"
+#include <stdexcept>
+#include "engine.h"
+
+namespace BoneHistory {
+static Frame frames[numTicks][maxNumberOfHumans];
+static bool recorded[numTicks][maxNumberOfHumans];
+static unsigned int latest;
+static unsigned int numRecorded;
+
+static inline void save(const Human* man, Frame* frame) {
+	frame->pos = man->pos;
+	for (int i = 0; i < 15; i++) {
+		frame->bonePos[i] = man->bones[i].pos;
+		frame->boneRot[i] = man->bones[i].rot;
+	}
+}
+
+static inline void load(Human* man, const Frame* frame) {
+	man->pos = frame->pos;
+	for (int i = 0; i < 15; i++) {
+		man->bones[i].pos = frame->bonePos[i];
+		man->bones[i].rot = frame->boneRot[i];
+	}
+}
+
+void record() {
+	latest = (latest + 1) % numTicks;
+	if (numRecorded < numTicks) numRecorded++;
+
+	for (int i = 0; i < maxNumberOfHumans; i++) {
+		const Human* man = &Engine::humans[i];
+		recorded[latest][i] = man->active;
+		if (man->active) save(man, &frames[latest][i]);
+	}
+}
+
+void forget(int humanID) {
+	for (unsigned int tick = 0; tick < numTicks; tick++)
+		recorded[tick][humanID] = false;
+}
+
+bool rewind(int humanID, unsigned int ticksAgo, Frame* saved) {
+	if (ticksAgo >= numTicks) throw std::invalid_argument("Index out of range");
+	if (ticksAgo >= numRecorded) return false;
+
+	unsigned int tick = (latest + numTicks - ticksAgo) % numTicks;
+	if (!recorded[tick][humanID]) return false;
+
+	Human* man = &Engine::humans[humanID];
+	save(man, saved);
+	load(man, &frames[tick][humanID]);
+	return true;
+}
+
+void restore(int humanID, const Frame* saved) {
+	load(&Engine::humans[humanID], saved);
+}
+}  // namespace BoneHistory
@@ -0,0 +1,22 @@
+#pragma once
+#include "structs.h"
+
+// Recent bone positions of every human, for rewinding hit detection
+namespace BoneHistory {
+constexpr unsigned int numTicks = 64;
+
+struct Frame {
+	Vector pos;
+	Vector bonePos[15];
+	RotMatrix boneRot[15];
+};
+
+// Called once per tick after physics
+void record();
+// Drops everything recorded for a human slot, e.g. when it is reused
+void forget(int humanID);
+// Swaps a human's bones with those recorded ticksAgo, saving the current ones
+// into saved. Returns false if the human was not recorded at that tick.
+bool rewind(int humanID, unsigned int ticksAgo, Frame* saved);
+void restore(int humanID, const Frame* saved);
+}  // namespace BoneHistory
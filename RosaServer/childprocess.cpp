@@ -1,73 +1,158 @@
 #include "childprocess.h"
+#include "api.h"
+#include "serialize.h"
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <spawn.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <fstream>
+#include <sstream>
 #include <thread>
 
-ChildProcess::ChildProcess(std::string fileName) {
-	if (pipe(fdParentToChild) == -1) {
-		throw std::runtime_error(strerror(errno));
-	}
+// Where the satellite finds its ends of the pipes, and the shared ring region
+static constexpr int childReadFD = 3;
+static constexpr int childWriteFD = 4;
+static constexpr int childSharedFD = 5;
 
-	if (pipe(fdChildToParent) == -1) {
-		close(fdParentToChild[0]);
-		close(fdParentToChild[1]);
+extern char** environ;
 
-		throw std::runtime_error(strerror(errno));
+// Keeps fd clear of the numbers it's about to be duplicated onto
+static int moveAbove(int fd, int minFD) {
+	if (fd >= minFD) return fd;
+
+	int moved = fcntl(fd, F_DUPFD_CLOEXEC, minFD);
+	int savedErrno = errno;
+	close(fd);
+	errno = savedErrno;
+	return moved;
+}
+
+#if !(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+// Without posix_spawn_file_actions_addclosefrom_np, anything opened without
+// O_CLOEXEC would leak into the child
+static void markAllCloseOnExec() {
+	DIR* dir = opendir("/proc/self/fd");
+	if (!dir) return;
+
+	int dirFD = dirfd(dir);
+	while (dirent* entry = readdir(dir)) {
+		int fd = atoi(entry->d_name);
+		if (fd <= STDERR_FILENO || fd == dirFD) continue;
+
+		int flags = fcntl(fd, F_GETFD);
+		if (flags != -1 && !(flags & FD_CLOEXEC))
+			fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
 	}
 
-	pid = fork();
+	closedir(dir);
+}
+#endif
 
-	if (pid == -1) {
-		close(fdParentToChild[0]);
-		close(fdParentToChild[1]);
-		close(fdChildToParent[0]);
-		close(fdChildToParent[1]);
+ChildProcess::ChildProcess(Pooled) : ChildProcess("--pool") {}
+
+ChildProcess::ChildProcess(std::string fileName)
+    : ChildProcess(fileName, sol::table()) {}
+
+ChildProcess::ChildProcess(std::string fileName, sol::table options) {
+	if (options.valid()) {
+		sol::optional<size_t> ringSize = options["ringSize"];
+		if (ringSize) shared = std::make_unique<SharedRing::Region>(*ringSize);
+	}
 
+	if (pipe2(fdParentToChild, O_CLOEXEC) == -1) {
 		throw std::runtime_error(strerror(errno));
 	}
 
-	if (pid != 0) {
+	if (pipe2(fdChildToParent, O_CLOEXEC) == -1) {
 		close(fdParentToChild[0]);
-		close(fdChildToParent[1]);
-
-		fcntl(fdChildToParent[0], F_SETFL, O_NONBLOCK);
-	} else {
 		close(fdParentToChild[1]);
-		close(fdChildToParent[0]);
 
-		// Set reading the pipe to not block execution
-		fcntl(fdParentToChild[0], F_SETFL, O_NONBLOCK);
-
-		char strFromParentFD[10];
-		char strToParentFD[10];
-
-		sprintf(strFromParentFD, "%i", fdParentToChild[0]);
-		sprintf(strToParentFD, "%i", fdChildToParent[1]);
-
-		char* args[] = {(char*)"./rosaserversatellite", strFromParentFD,
-		                strToParentFD, (char*)fileName.c_str(), nullptr};
+		throw std::runtime_error(strerror(errno));
+	}
 
-		char workingDirectory[PATH_MAX];
+	auto closeAll = [this]() {
+		int savedErrno = errno;
+		for (int fd : {fdParentToChild[0], fdParentToChild[1], fdChildToParent[0],
+		               fdChildToParent[1]})
+			if (fd != -1) close(fd);
+		errno = savedErrno;
+	};
+
+	fdParentToChild[0] = moveAbove(fdParentToChild[0], childSharedFD + 1);
+	fdChildToParent[1] = moveAbove(fdChildToParent[1], childSharedFD + 1);
+	if (fdParentToChild[0] == -1 || fdChildToParent[1] == -1) {
+		closeAll();
+		throw std::runtime_error(strerror(errno));
+	}
 
-		if (getcwd(workingDirectory, sizeof(workingDirectory)) == nullptr) {
-			perror("getcwd");
-			exit(1);
+	// The region keeps its own fd, this copy is only for the child
+	int sharedFD = -1;
+	if (shared) {
+		sharedFD = fcntl(shared->getFD(), F_DUPFD_CLOEXEC, childSharedFD + 1);
+		if (sharedFD == -1) {
+			closeAll();
+			throw std::runtime_error(strerror(errno));
 		}
+	}
 
-		char ldPreload[PATH_MAX + 64];
-		sprintf(ldPreload, "LD_PRELOAD=%s/libluajit.so", workingDirectory);
+	// Set reading the pipe to not block execution in the child
+	fcntl(fdParentToChild[0], F_SETFL, O_NONBLOCK);
+	fcntl(fdChildToParent[0], F_SETFL, O_NONBLOCK);
 
-		char* env[] = {ldPreload, nullptr};
+	char workingDirectory[PATH_MAX];
+	if (getcwd(workingDirectory, sizeof(workingDirectory)) == nullptr) {
+		closeAll();
+		throw std::runtime_error(strerror(errno));
+	}
 
-		if (execvpe(args[0], args, env) == -1) {
-			perror("execvpe");
-			exit(1);
-		}
+	std::string ldPreload =
+	    std::string("LD_PRELOAD=") + workingDirectory + "/libluajit.so";
+	char* env[] = {ldPreload.data(), nullptr};
+
+	std::string strFromParentFD = std::to_string(childReadFD);
+	std::string strToParentFD = std::to_string(childWriteFD);
+	std::string strSharedFD = std::to_string(childSharedFD);
+	char* args[] = {(char*)"./rosaserversatellite", strFromParentFD.data(),
+	                strToParentFD.data(), fileName.data(),
+	                shared ? strSharedFD.data() : nullptr, nullptr};
+
+	// dup2 clears O_CLOEXEC on the copies, so they're all the child inherits
+	// besides stdio
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, fdParentToChild[0], childReadFD);
+	posix_spawn_file_actions_adddup2(&actions, fdChildToParent[1], childWriteFD);
+	if (shared)
+		posix_spawn_file_actions_adddup2(&actions, sharedFD, childSharedFD);
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34)
+	posix_spawn_file_actions_addclosefrom_np(
+	    &actions, shared ? childSharedFD + 1 : childSharedFD);
+#else
+	markAllCloseOnExec();
+#endif
+
+	// glibc spawns with CLONE_VM | CLONE_VFORK, so none of the server's memory
+	// gets copied, and exec failures come back as the result
+	int err = posix_spawn(&pid, args[0], &actions, nullptr, args, env);
+	posix_spawn_file_actions_destroy(&actions);
+
+	close(fdParentToChild[0]);
+	close(fdChildToParent[1]);
+	if (sharedFD != -1) close(sharedFD);
+
+	if (err) {
+		close(fdParentToChild[1]);
+		close(fdChildToParent[0]);
+		pid = -1;
+
+		throw std::runtime_error(strerror(err));
 	}
+
+	reader.setFD(fdChildToParent[0]);
 }
 
 ChildProcess::~ChildProcess() { terminate(); }
@@ -95,20 +180,23 @@ bool ChildProcess::isRunning() {
 
 void ChildProcess::terminate() {
 	if (pid != -1) {
-		if (kill(pid, SIGTERM) == -1) {
-			if (errno != ESRCH) {
-				throw std::runtime_error(strerror(errno));
-			}
-		} else {
-			int status;
-			int retPID = waitpid(pid, &status, 0);
-
-			if (retPID == -1) {
-				throw std::runtime_error(strerror(errno));
+		// Once reaped, the PID could already belong to some other process
+		if (!gotExitCode) {
+			if (kill(pid, SIGTERM) == -1) {
+				if (errno != ESRCH) {
+					throw std::runtime_error(strerror(errno));
+				}
+			} else {
+				int status;
+				int retPID = waitpid(pid, &status, 0);
+
+				if (retPID == -1) {
+					throw std::runtime_error(strerror(errno));
+				}
+
+				gotExitCode = true;
+				exitCode = status;
 			}
-
-			gotExitCode = true;
-			exitCode = status;
 		}
 
 		// Close file handles
@@ -131,49 +219,148 @@ sol::object ChildProcess::getExitCode(sol::this_state s) {
 	return sol::make_object(lua, sol::lua_nil);
 }
 
-sol::object ChildProcess::receiveMessage(sol::this_state s) {
-	sol::state_view lua(s);
+// Sorts whatever has arrived into messages for scripts and replies for us
+void ChildProcess::pump() {
+	// Satellites with a shared ring only use the pipes to notice exits
+	if (shared) {
+		std::string message;
+		while (shared->toServer.tryRead(message))
+			pending.push_back(std::move(message));
+		return;
+	}
 
-	unsigned int length;
+	reader.fill();
 
-	auto bytesRead = read(fdChildToParent[0], &length, sizeof(length));
-	if (bytesRead == -1) {
-		if (errno != EAGAIN) {
-			throw std::runtime_error(strerror(errno));
+	std::string frame;
+	bool isControl;
+	while (reader.next(frame, isControl)) {
+		if (!isControl) {
+			pending.push_back(std::move(frame));
+		} else if (frame.size() == 2 && frame[0] == Framing::controlJobDone) {
+			jobRunning = false;
+			jobStatus = static_cast<unsigned char>(frame[1]);
 		}
-	} else if (bytesRead == sizeof(length)) {
-		std::string message(length, ' ');
-		bytesRead = read(fdChildToParent[0], message.data(), length);
-		if (bytesRead == -1) {
-			if (errno != EAGAIN) {
-				throw std::runtime_error(strerror(errno));
-			}
-		} else if (bytesRead == length) {
-			return sol::make_object(lua, message);
+	}
+}
+
+void ChildProcess::deliver(const std::string& message) {
+	if (shared) {
+		shared->toSatellite.write(message.data(), message.size(),
+		                          [this]() { return isRunning(); });
+		if (shared->toSatellite.isReaderPolling()) {
+			static const std::string wake(1, Framing::controlWake);
+			Framing::write(fdParentToChild[1], wake, true);
 		}
+		return;
+	}
+
+	Framing::write(fdParentToChild[1], message);
+}
+
+bool ChildProcess::nextMessage(std::string& message) {
+	if (pending.empty()) pump();
+	if (pending.empty()) return false;
+
+	message = std::move(pending.front());
+	pending.pop_front();
+	return true;
+}
+
+sol::object ChildProcess::receiveMessage(sol::this_state s) {
+	sol::state_view lua(s);
+
+	std::string message;
+	if (nextMessage(message)) {
+		return sol::make_object(lua, message);
 	}
 
 	return sol::make_object(lua, sol::lua_nil);
 }
 
+sol::table ChildProcess::receiveMessages(sol::this_state s) {
+	sol::state_view lua(s);
+
+	pump();
+
+	sol::table messages = lua.create_table(pending.size());
+	int count = 0;
+	for (auto& message : pending) messages[++count] = std::move(message);
+	pending.clear();
+
+	return messages;
+}
+
 void ChildProcess::sendMessage(std::string message) {
 	if (!isRunning()) return;
 
-	unsigned int length = static_cast<unsigned int>(message.length());
+	deliver(message);
+}
 
-	auto bytesWritten = write(fdParentToChild[1], &length, sizeof(length));
-	if (bytesWritten == -1) {
-		throw std::runtime_error(strerror(errno));
-	} else if (bytesWritten != sizeof(length)) {
-		throw std::runtime_error("Couldn't write full message to pipe");
-	} else {
-		bytesWritten = write(fdParentToChild[1], message.data(), length);
-		if (bytesWritten == -1) {
-			throw std::runtime_error(strerror(errno));
-		} else if (bytesWritten != length) {
-			throw std::runtime_error("Couldn't write full message to pipe");
-		}
+sol::object ChildProcess::receiveValue(sol::this_state s) {
+	std::string encoded;
+	if (nextMessage(encoded)) {
+		return Serialize::decode(s, encoded, getSerializeCodec());
 	}
+
+	return sol::make_object(s, sol::lua_nil);
+}
+
+void ChildProcess::sendValue(sol::object value) {
+	if (!isRunning()) return;
+
+	deliver(Serialize::encode(value, getSerializeCodec()));
+}
+
+void ChildProcess::startJob(Framing::Control control,
+                            const std::string& source) {
+	jobRunning = true;
+	jobStatus = -1;
+
+	std::string frame(1, control);
+	frame += source;
+	Framing::write(fdParentToChild[1], frame, true);
+}
+
+void ChildProcess::discardMessages() {
+	pump();
+	pending.clear();
+}
+
+// User and system time, which is what RLIMIT_CPU counts
+double ChildProcess::getCPUSeconds() {
+	std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+	std::string contents((std::istreambuf_iterator<char>(stat)),
+	                     std::istreambuf_iterator<char>());
+
+	// The command name can contain anything, so start after it
+	auto nameEnd = contents.rfind(')');
+	if (nameEnd == std::string::npos) return 0;
+
+	std::istringstream fields(contents.substr(nameEnd + 2));
+	std::string field;
+	// State is field 3, utime and stime are 14 and 15
+	for (int i = 3; i < 14; i++) fields >> field;
+
+	unsigned long long userTicks = 0, systemTicks = 0;
+	fields >> userTicks >> systemTicks;
+	return static_cast<double>(userTicks + systemTicks) / sysconf(_SC_CLK_TCK);
+}
+
+bool ChildProcess::setSoftLimit(__rlimit_resource resource, rlim_t softLimit) {
+	rlimit limits;
+	if (prlimit(pid, resource, nullptr, &limits) == -1) return false;
+	if (limits.rlim_max != RLIM_INFINITY && softLimit > limits.rlim_max)
+		return false;
+
+	limits.rlim_cur = softLimit;
+	return prlimit(pid, resource, &limits, nullptr) == 0;
+}
+
+sol::object ChildProcess::getJobStatus(sol::this_state s) {
+	pump();
+
+	if (jobRunning || jobStatus == -1) return sol::make_object(s, sol::lua_nil);
+	return sol::make_object(s, jobStatus);
 }
 
 void ChildProcess::setLimit(__rlimit_resource resource, rlim_t softLimit,
@@ -1,30 +1,65 @@
 #pragma once
+#include "framing.h"
+#include "sharedring.h"
 #include "sol/sol.hpp"
 
 #include <sys/resource.h>
+#include <deque>
+#include <memory>
 #include <string>
 
 class ChildProcess {
+	friend class SatellitePool;
+
 	int fdParentToChild[2];
 	int fdChildToParent[2];
 	int pid;
+	Framing::Reader reader;
+	// Messages read while looking for control frames
+	std::deque<std::string> pending;
+	// Replaces the pipes for messages when a ring size is given
+	std::unique_ptr<SharedRing::Region> shared;
 
 	bool gotExitCode = false;
 	int exitCode;
 
+	bool jobRunning = false;
+	int jobStatus = -1;
+
 	void setLimit(__rlimit_resource resource, rlim_t softLimit, rlim_t hardLimit);
+	void pump();
+	bool nextMessage(std::string& message);
+	void deliver(const std::string& message);
+
+	// Pooled satellites wait for jobs instead of running a file
+	struct Pooled {};
+	ChildProcess(Pooled);
+	void startJob(Framing::Control control, const std::string& source);
+	void discardMessages();
+	double getCPUSeconds();
+	// Leaves the hard limit alone so it can be raised again for the next job
+	bool setSoftLimit(__rlimit_resource resource, rlim_t softLimit);
 
  public:
 	ChildProcess(std::string fileName);
+	// Options: ringSize, to send messages through shared memory rings of at
+	// least that many bytes instead of the pipes
+	ChildProcess(std::string fileName, sol::table options);
 	~ChildProcess();
 	bool isRunning();
 	void terminate();
 	sol::object getExitCode(sol::this_state s);
 	sol::object receiveMessage(sol::this_state s);
+	// Every complete message that has arrived, in order
+	sol::table receiveMessages(sol::this_state s);
 	void sendMessage(std::string message);
+	sol::object receiveValue(sol::this_state s);
+	void sendValue(sol::object value);
 	void setCPULimit(rlim_t softLimit, rlim_t hardLimit);
 	void setMemoryLimit(rlim_t softLimit, rlim_t hardLimit);
 	void setFileSizeLimit(rlim_t softLimit, rlim_t hardLimit);
 	int getPriority();
 	void setPriority(int nice);
+	// For pooled satellites, nil until the job finishes, then its status code
+	sol::object getJobStatus(sol::this_state s);
 };
\ No newline at end of file
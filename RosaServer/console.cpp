@@ -2,6 +2,7 @@
 // https://github.com/unix-ninja/hackersandbox/blob/master/tinycon.cpp
 
 #include "console.h"
+#include "logger.h"
 
 #include <termios.h>
 #include <unistd.h>
@@ -386,12 +387,14 @@ void cleanup() {
 	tcsetattr(STDIN_FILENO, TCSANOW, &mode);
 }
 
-void log(std::string line) {
+void log(std::string line) { Logger::log(Logger::levelInfo, std::move(line)); }
+
+void write(const std::string& text) {
 	std::lock_guard<std::mutex> guard(outputMutex);
 
 	// Erase current line, move cursor to start, print
 	std::cout << "\33[2K\r";
-	std::cout << line;
+	std::cout << text;
 
 	if (inputInitialized && !shouldExit) redrawLine();
 }
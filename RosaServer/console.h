@@ -17,7 +17,11 @@ void respondToAutoComplete(std::string newBuffer);
 void threadMain();
 void init();
 void cleanup();
+// Queued for the logger's thread, at info level
 void log(std::string line);
+// Writes straight to the terminal and redraws the input line, only meant for
+// the logger's thread
+void write(const std::string& text);
 void handleInterruptSignal(int signal);
 void setTitle(const char* title);
 }  // namespace Console
\ No newline at end of file
@@ -8,6 +8,7 @@ int* gameState;
 int* gameTimer;
 int* gameTicksSinceReset;
 unsigned int* sunTime;
+float* gravity;
 
 RayCastResult* lineIntersectResult;
 
@@ -9,6 +9,7 @@ extern int* gameState;
 extern int* gameTimer;
 extern int* gameTicksSinceReset;
 extern unsigned int* sunTime;
+extern float* gravity;
 
 extern RayCastResult* lineIntersectResult;
 
@@ -0,0 +1,405 @@
+#include "ffimath.h"
+#include "api.h"
+
+// The FFI structs below must match these exactly
+static_assert(sizeof(Vector) == 3 * sizeof(float), "Vector layout changed");
+static_assert(sizeof(RotMatrix) == 9 * sizeof(float),
+              "RotMatrix layout changed");
+
+static constexpr const char* ffiMathSource = R"lua(
+local ffi, toVector, toRotMatrix, addressOfVector, addressOfRotMatrix = ...
+
+local sqrt = math.sqrt
+local floor = math.floor
+local sin = math.sin
+local cos = math.cos
+local acos = math.acos
+local format = string.format
+
+ffi.cdef [[
+typedef struct {
+	float x, y, z;
+} RosaVector;
+
+typedef struct {
+	float x1, y1, z1;
+	float x2, y2, z2;
+	float x3, y3, z3;
+} RosaRotMatrix;
+]]
+
+local vectorPtr = ffi.typeof('RosaVector*')
+local rotMatrixPtr = ffi.typeof('RosaRotMatrix*')
+
+local Vector
+local RotMatrix
+
+local function isObject (value)
+	local t = type(value)
+	return t == 'cdata' or t == 'userdata'
+end
+
+local function truncate (n)
+	if n < 0 then return -floor(-n) end
+	return floor(n)
+end
+
+local vectorMethods = { class = 'Vector' }
+
+function vectorMethods:add (other)
+	self.x = self.x + other.x
+	self.y = self.y + other.y
+	self.z = self.z + other.z
+end
+
+function vectorMethods:mult (scalar)
+	self.x = self.x * scalar
+	self.y = self.y * scalar
+	self.z = self.z * scalar
+end
+
+function vectorMethods:set (other)
+	self.x = other.x
+	self.y = other.y
+	self.z = other.z
+end
+
+function vectorMethods:cross (other)
+	local x, y, z = self.x, self.y, self.z
+	self.x = y * other.z - z * other.y
+	self.y = z * other.x - x * other.z
+	self.z = x * other.y - y * other.x
+end
+
+function vectorMethods:addScaled (other, scalar)
+	self.x = self.x + other.x * scalar
+	self.y = self.y + other.y * scalar
+	self.z = self.z + other.z * scalar
+end
+
+function vectorMethods:lerpTo (other, t)
+	self.x = self.x + (other.x - self.x) * t
+	self.y = self.y + (other.y - self.y) * t
+	self.z = self.z + (other.z - self.z) * t
+end
+
+function vectorMethods:transformInto (rot, out)
+	local x, y, z = self.x, self.y, self.z
+	out.x = rot.x1 * x + rot.y1 * y + rot.z1 * z
+	out.y = rot.x2 * x + rot.y2 * y + rot.z2 * z
+	out.z = rot.x3 * x + rot.y3 * y + rot.z3 * z
+end
+
+function vectorMethods:rotateBy (rot)
+	self:transformInto(rot, self)
+end
+
+function vectorMethods:clone ()
+	return Vector(self.x, self.y, self.z)
+end
+
+function vectorMethods:distSquare (other)
+	local dx = self.x - other.x
+	local dy = self.y - other.y
+	local dz = self.z - other.z
+	return dx * dx + dy * dy + dz * dz
+end
+
+function vectorMethods:dist (other)
+	return sqrt(self:distSquare(other))
+end
+
+function vectorMethods:lengthSquare ()
+	return self.x * self.x + self.y * self.y + self.z * self.z
+end
+
+function vectorMethods:length ()
+	return sqrt(self:lengthSquare())
+end
+
+function vectorMethods:dot (other)
+	return self.x * other.x + self.y * other.y + self.z * other.z
+end
+
+function vectorMethods:getBlockPos ()
+	return truncate(self.x / 4), truncate(self.y / 4), truncate(self.z / 4)
+end
+
+function vectorMethods:normalize ()
+	local length = self:length()
+	self.x = self.x / length
+	self.y = self.y / length
+	self.z = self.z / length
+	return self
+end
+
+-- Copy into a userdata Vector, for bindings which take one
+function vectorMethods:toVector ()
+	return toVector(self.x, self.y, self.z)
+end
+
+Vector = ffi.metatype('RosaVector', {
+	__index = vectorMethods,
+	__tostring = function (self)
+		return format('Vector(%f, %f, %f)', self.x, self.y, self.z)
+	end,
+	__eq = function (a, b)
+		if not isObject(a) or not isObject(b) then return false end
+		return a.x == b.x and a.y == b.y and a.z == b.z
+	end,
+	__add = function (a, b)
+		return Vector(a.x + b.x, a.y + b.y, a.z + b.z)
+	end,
+	__sub = function (a, b)
+		return Vector(a.x - b.x, a.y - b.y, a.z - b.z)
+	end,
+	__mul = function (a, b)
+		if type(b) == 'number' then
+			return Vector(a.x * b, a.y * b, a.z * b)
+		end
+		return Vector(
+			b.x1 * a.x + b.y1 * a.y + b.z1 * a.z,
+			b.x2 * a.x + b.y2 * a.y + b.z2 * a.z,
+			b.x3 * a.x + b.y3 * a.y + b.z3 * a.z
+		)
+	end,
+	__div = function (a, scalar)
+		return Vector(a.x / scalar, a.y / scalar, a.z / scalar)
+	end,
+	__unm = function (a)
+		return Vector(-a.x, -a.y, -a.z)
+	end
+})
+
+local rotMatrixMethods = { class = 'RotMatrix' }
+
+function rotMatrixMethods:set (other)
+	self.x1, self.y1, self.z1 = other.x1, other.y1, other.z1
+	self.x2, self.y2, self.z2 = other.x2, other.y2, other.z2
+	self.x3, self.y3, self.z3 = other.x3, other.y3, other.z3
+end
+
+function rotMatrixMethods:rotateBy (b)
+	local a1, b1, c1 = self.x1, self.y1, self.z1
+	local a2, b2, c2 = self.x2, self.y2, self.z2
+	local a3, b3, c3 = self.x3, self.y3, self.z3
+
+	self.x1 = a1 * b.x1 + b1 * b.x2 + c1 * b.x3
+	self.y1 = a1 * b.y1 + b1 * b.y2 + c1 * b.y3
+	self.z1 = a1 * b.z1 + b1 * b.z2 + c1 * b.z3
+
+	self.x2 = a2 * b.x1 + b2 * b.x2 + c2 * b.x3
+	self.y2 = a2 * b.y1 + b2 * b.y2 + c2 * b.y3
+	self.z2 = a2 * b.z1 + b2 * b.z2 + c2 * b.z3
+
+	self.x3 = a3 * b.x1 + b3 * b.x2 + c3 * b.x3
+	self.y3 = a3 * b.y1 + b3 * b.y2 + c3 * b.y3
+	self.z3 = a3 * b.z1 + b3 * b.z2 + c3 * b.z3
+end
+
+local function normalized (x, y, z)
+	local length = sqrt(x * x + y * y + z * z)
+	if length == 0 then return x, y, z end
+	return x / length, y / length, z / length
+end
+
+local function withoutProjection (x, y, z, ax, ay, az)
+	local dot = x * ax + y * ay + z * az
+	return x - ax * dot, y - ay * dot, z - az * dot
+end
+
+function rotMatrixMethods:orthonormalize ()
+	local x1, y1, z1 = normalized(self.x1, self.y1, self.z1)
+
+	local x2, y2, z2 = withoutProjection(self.x2, self.y2, self.z2, x1, y1, z1)
+	x2, y2, z2 = normalized(x2, y2, z2)
+
+	local x3, y3, z3 = withoutProjection(self.x3, self.y3, self.z3, x1, y1, z1)
+	x3, y3, z3 = withoutProjection(x3, y3, z3, x2, y2, z2)
+	x3, y3, z3 = normalized(x3, y3, z3)
+
+	self.x1, self.y1, self.z1 = x1, y1, z1
+	self.x2, self.y2, self.z2 = x2, y2, z2
+	self.x3, self.y3, self.z3 = x3, y3, z3
+end
+
+function rotMatrixMethods:fromEuler (rotX, rotY, rotZ)
+	local s1, s2, s3 = sin(rotX), sin(rotY), sin(rotZ)
+	local c1, c2, c3 = cos(rotX), cos(rotY), cos(rotZ)
+
+	self.x1 = c2 * c3
+	self.y1 = -c2 * s3
+	self.z1 = s2
+
+	self.x2 = c1 * s3 + c3 * s1 * s2
+	self.y2 = c1 * c3 - s1 * s2 * s3
+	self.z2 = -c2 * s1
+
+	self.x3 = s1 * s3 - c1 * c3 * s2
+	self.y3 = c3 * s1 + c1 * s2 * s3
+	self.z3 = c1 * c2
+end
+
+local function toQuaternion (m)
+	local trace = m.x1 + m.y2 + m.z3
+
+	if trace > 0 then
+		local s = sqrt(trace + 1) * 2
+		return 0.25 * s, (m.y3 - m.z2) / s, (m.z1 - m.x3) / s, (m.x2 - m.y1) / s
+	elseif m.x1 > m.y2 and m.x1 > m.z3 then
+		local s = sqrt(1 + m.x1 - m.y2 - m.z3) * 2
+		return (m.y3 - m.z2) / s, 0.25 * s, (m.y1 + m.x2) / s, (m.z1 + m.x3) / s
+	elseif m.y2 > m.z3 then
+		local s = sqrt(1 + m.y2 - m.x1 - m.z3) * 2
+		return (m.z1 - m.x3) / s, (m.y1 + m.x2) / s, 0.25 * s, (m.z2 + m.y3) / s
+	end
+
+	local s = sqrt(1 + m.z3 - m.x1 - m.y2) * 2
+	return (m.x2 - m.y1) / s, (m.z1 + m.x3) / s, (m.z2 + m.y3) / s, 0.25 * s
+end
+
+function rotMatrixMethods:slerp (other, t)
+	local aw, ax, ay, az = toQuaternion(self)
+	local bw, bx, by, bz = toQuaternion(other)
+
+	local dot = aw * bw + ax * bx + ay * by + az * bz
+	if dot < 0 then
+		bw, bx, by, bz = -bw, -bx, -by, -bz
+		dot = -dot
+	end
+
+	local scaleA, scaleB
+	if dot > 0.9995 then
+		scaleA, scaleB = 1 - t, t
+	else
+		local theta = acos(dot)
+		local sinTheta = sin(theta)
+		scaleA = sin((1 - t) * theta) / sinTheta
+		scaleB = sin(t * theta) / sinTheta
+	end
+
+	local w = scaleA * aw + scaleB * bw
+	local x = scaleA * ax + scaleB * bx
+	local y = scaleA * ay + scaleB * by
+	local z = scaleA * az + scaleB * bz
+	local length = sqrt(w * w + x * x + y * y + z * z)
+	w, x, y, z = w / length, x / length, y / length, z / length
+
+	self.x1 = 1 - 2 * (y * y + z * z)
+	self.y1 = 2 * (x * y - z * w)
+	self.z1 = 2 * (x * z + y * w)
+
+	self.x2 = 2 * (x * y + z * w)
+	self.y2 = 1 - 2 * (x * x + z * z)
+	self.z2 = 2 * (y * z - x * w)
+
+	self.x3 = 2 * (x * z - y * w)
+	self.y3 = 2 * (y * z + x * w)
+	self.z3 = 1 - 2 * (x * x + y * y)
+end
+
+function rotMatrixMethods:clone ()
+	return RotMatrix(
+		self.x1, self.y1, self.z1,
+		self.x2, self.y2, self.z2,
+		self.x3, self.y3, self.z3
+	)
+end
+
+function rotMatrixMethods:getForward ()
+	return Vector(self.x1, self.y1, self.z1)
+end
+
+function rotMatrixMethods:getUp ()
+	return Vector(self.x2, self.y2, self.z2)
+end
+
+function rotMatrixMethods:getRight ()
+	return Vector(self.x3, self.y3, self.z3)
+end
+
+-- Copy into a userdata RotMatrix, for bindings which take one
+function rotMatrixMethods:toRotMatrix ()
+	return toRotMatrix(
+		self.x1, self.y1, self.z1,
+		self.x2, self.y2, self.z2,
+		self.x3, self.y3, self.z3
+	)
+end
+
+RotMatrix = ffi.metatype('RosaRotMatrix', {
+	__index = rotMatrixMethods,
+	__tostring = function (self)
+		return format(
+			'RotMatrix(%f, %f, %f, %f, %f, %f, %f, %f, %f)',
+			self.x1, self.y1, self.z1,
+			self.x2, self.y2, self.z2,
+			self.x3, self.y3, self.z3
+		)
+	end,
+	__mul = function (a, b)
+		return RotMatrix(
+			a.x1 * b.x1 + a.y1 * b.x2 + a.z1 * b.x3,
+			a.x1 * b.y1 + a.y1 * b.y2 + a.z1 * b.y3,
+			a.x1 * b.z1 + a.y1 * b.z2 + a.z1 * b.z3,
+
+			a.x2 * b.x1 + a.y2 * b.x2 + a.z2 * b.x3,
+			a.x2 * b.y1 + a.y2 * b.y2 + a.z2 * b.y3,
+			a.x2 * b.z1 + a.y2 * b.z2 + a.z2 * b.z3,
+
+			a.x3 * b.x1 + a.y3 * b.x2 + a.z3 * b.x3,
+			a.x3 * b.y1 + a.y3 * b.y2 + a.z3 * b.y3,
+			a.x3 * b.z1 + a.y3 * b.z2 + a.z3 * b.z3
+		)
+	end
+})
+
+local ffiMath = {
+	Vector = Vector,
+	RotMatrix = RotMatrix
+}
+
+function ffiMath.fromVector (vec)
+	return Vector(vec.x, vec.y, vec.z)
+end
+
+function ffiMath.fromRotMatrix (rot)
+	return RotMatrix(
+		rot.x1, rot.y1, rot.z1,
+		rot.x2, rot.y2, rot.z2,
+		rot.x3, rot.y3, rot.z3
+	)
+end
+
+-- Views share memory with the userdata (and the engine, for fields like
+-- human.pos), so they are only valid while the source is.
+function ffiMath.viewVector (vec)
+	return ffi.cast(vectorPtr, addressOfVector(vec))[0]
+end
+
+function ffiMath.viewRotMatrix (rot)
+	return ffi.cast(rotMatrixPtr, addressOfRotMatrix(rot))[0]
+end
+
+return ffiMath
+)lua";
+
+static uintptr_t addressOfVector(Vector* vec) {
+	if (!vec) throw std::invalid_argument("Missing argument");
+	return (uintptr_t)vec;
+}
+
+static uintptr_t addressOfRotMatrix(RotMatrix* rot) {
+	if (!rot) throw std::invalid_argument("Missing argument");
+	return (uintptr_t)rot;
+}
+
+void defineFFIMath(sol::state* state) {
+	auto load = state->load(ffiMathSource, "=ffimath");
+	if (!noLuaCallError(&load)) return;
+
+	sol::protected_function chunk = load;
+	auto res = chunk((*state)["ffi"], Lua::Vector_3f, Lua::RotMatrix_,
+	                 addressOfVector, addressOfRotMatrix);
+	if (noLuaCallError(&res)) (*state)["ffiMath"] = res.get<sol::table>();
+}
@@ -0,0 +1,4 @@
+#pragma once
+#include "sol/sol.hpp"
+
+void defineFFIMath(sol::state* state);
@@ -0,0 +1,217 @@
+#include "flightrecorder.h"
+
+#include <execinfo.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+namespace FlightRecorder {
+struct Slot {
+	// Odd while being written, otherwise twice the position plus two. Readers
+	// check it before and after, so they never see half an entry.
+	std::atomic_uint64_t sequence{0};
+	std::atomic<const char*> event{nullptr};
+	std::atomic_int32_t entity{0};
+	std::atomic_uint32_t tick{0};
+	std::atomic_uint64_t start{0};
+	// Zero until the dispatch returns
+	std::atomic_uint64_t duration{0};
+};
+
+struct SlotContents {
+	const char* event;
+	int entity;
+	uint32_t tick;
+	uint64_t start;
+	uint64_t duration;
+};
+
+static Slot slots[capacity];
+static std::atomic_size_t nextPosition{0};
+static std::atomic_uint32_t currentTick{0};
+
+static uint64_t getNanoseconds() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+Scope::Scope(const char* event, int entity)
+    : position(nextPosition.fetch_add(1, std::memory_order_relaxed)),
+      start(getNanoseconds()) {
+	Slot& slot = slots[position & (capacity - 1)];
+
+	slot.sequence.store(position * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.event.store(event, std::memory_order_relaxed);
+	slot.entity.store(entity, std::memory_order_relaxed);
+	slot.tick.store(currentTick.load(std::memory_order_relaxed),
+	                std::memory_order_relaxed);
+	slot.start.store(start, std::memory_order_relaxed);
+	slot.duration.store(0, std::memory_order_relaxed);
+	slot.sequence.store(position * 2 + 2, std::memory_order_release);
+}
+
+Scope::~Scope() {
+	Slot& slot = slots[position & (capacity - 1)];
+
+	// A long dispatch, like a whole tick, can outlive its slot
+	if (slot.sequence.load(std::memory_order_relaxed) != position * 2 + 2)
+		return;
+
+	uint64_t duration = getNanoseconds() - start;
+	slot.duration.store(std::max<uint64_t>(duration, 1),
+	                    std::memory_order_relaxed);
+}
+
+void nextTick() { currentTick.fetch_add(1, std::memory_order_relaxed); }
+
+static bool readSlot(size_t position, SlotContents& contents) {
+	const Slot& slot = slots[position & (capacity - 1)];
+
+	uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+	if (sequence != position * 2 + 2) return false;
+
+	contents.event = slot.event.load(std::memory_order_relaxed);
+	contents.entity = slot.entity.load(std::memory_order_relaxed);
+	contents.tick = slot.tick.load(std::memory_order_relaxed);
+	contents.start = slot.start.load(std::memory_order_relaxed);
+	contents.duration = slot.duration.load(std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+std::vector<Entry> getRecent(size_t count) {
+	size_t end = nextPosition.load(std::memory_order_acquire);
+	count = std::min({count, capacity, end});
+	uint64_t now = getNanoseconds();
+
+	std::vector<Entry> entries;
+	entries.reserve(count);
+
+	for (size_t position = end - count; position < end; position++) {
+		SlotContents contents;
+		if (!readSlot(position, contents)) continue;
+
+		entries.push_back(
+		    {contents.event, contents.entity, contents.tick,
+		     (now - std::min(now, contents.start)) / 1e9,
+		     contents.duration ? contents.duration / 1e9 : -1.});
+	}
+
+	return entries;
+}
+
+// Everything below runs in signal handlers, so it formats numbers itself and
+// only writes straight to the fd
+
+static void writeAll(int fd, const char* data, size_t length) {
+	while (length) {
+		ssize_t written = write(fd, data, length);
+		if (written == -1 && errno == EINTR) continue;
+		if (written <= 0) return;
+		data += written;
+		length -= written;
+	}
+}
+
+static void writeString(int fd, const char* text) {
+	writeAll(fd, text, strlen(text));
+}
+
+static void writeNumber(int fd, uint64_t value, int minDigits = 1) {
+	char digits[24];
+	int start = sizeof(digits);
+	do {
+		digits[--start] = '0' + value % 10;
+		value /= 10;
+	} while (value || static_cast<int>(sizeof(digits)) - start < minDigits);
+	writeAll(fd, digits + start, sizeof(digits) - start);
+}
+
+static void writeMilliseconds(int fd, uint64_t nanoseconds) {
+	writeNumber(fd, nanoseconds / 1000000);
+	writeString(fd, ".");
+	writeNumber(fd, nanoseconds / 1000 % 1000, 3);
+	writeString(fd, " ms");
+}
+
+// strsignal can allocate and look up translations
+static const char* getSignalName(int signal) {
+	switch (signal) {
+		case SIGABRT:
+			return "SIGABRT (aborted)";
+		case SIGBUS:
+			return "SIGBUS (bus error)";
+		case SIGFPE:
+			return "SIGFPE (arithmetic exception)";
+		case SIGILL:
+			return "SIGILL (illegal instruction)";
+		case SIGQUIT:
+			return "SIGQUIT (quit)";
+		case SIGSEGV:
+			return "SIGSEGV (segmentation fault)";
+		case SIGSYS:
+			return "SIGSYS (bad system call)";
+		case SIGTRAP:
+			return "SIGTRAP (trace trap)";
+		case SIGXCPU:
+			return "SIGXCPU (CPU time limit exceeded)";
+		case SIGXFSZ:
+			return "SIGXFSZ (file size limit exceeded)";
+		default:
+			return "unknown signal";
+	}
+}
+
+void dump(int fd) {
+	size_t end = nextPosition.load(std::memory_order_acquire);
+	size_t count = std::min(capacity, end);
+	uint64_t now = getNanoseconds();
+
+	writeString(fd, "Last ");
+	writeNumber(fd, count);
+	writeString(fd, " hook dispatches, oldest first, now at tick ");
+	writeNumber(fd, currentTick.load(std::memory_order_relaxed));
+	writeString(fd, ":\n");
+
+	for (size_t position = end - count; position < end; position++) {
+		SlotContents contents;
+		if (!readSlot(position, contents)) continue;
+
+		writeString(fd, "\t");
+		writeMilliseconds(fd, now - std::min(now, contents.start));
+		writeString(fd, " ago, tick ");
+		writeNumber(fd, contents.tick);
+		writeString(fd, ": ");
+		writeString(fd, contents.event);
+		if (contents.entity >= 0) {
+			writeString(fd, " #");
+			writeNumber(fd, contents.entity);
+		}
+
+		if (contents.duration) {
+			writeString(fd, " took ");
+			writeMilliseconds(fd, contents.duration);
+			writeString(fd, "\n");
+		} else {
+			writeString(fd, " was still running\n");
+		}
+	}
+}
+
+void writeCrashReport(int fd, int signal, void* const* frames, int numFrames) {
+	writeString(fd, "Crashed with ");
+	writeString(fd, getSignalName(signal));
+	writeString(fd, "\n\nStack traceback:\n");
+	// Writes straight to the fd, unlike backtrace_symbols
+	backtrace_symbols_fd(frames, numFrames, fd);
+	writeString(fd, "\n");
+	dump(fd);
+}
+}  // namespace FlightRecorder
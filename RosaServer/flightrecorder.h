@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Remembers the last few thousand hook dispatches in a fixed ring, so a crash
+// report can say what the server was doing just before. Recording is a few
+// stores and two clock reads, and dumping only makes async-signal-safe calls.
+namespace FlightRecorder {
+static constexpr size_t capacity = 16384;
+
+struct Entry {
+	// Event names are always string literals, so the pointer stays valid
+	const char* event;
+	int entity;
+	uint32_t tick;
+	double secondsAgo;
+	// Negative while the dispatch hasn't returned
+	double durationSeconds;
+};
+
+// Records one dispatch for as long as it's in scope
+class Scope {
+	size_t position;
+	uint64_t start;
+
+ public:
+	Scope(const char* event, int entity = -1);
+	~Scope();
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+};
+
+void nextTick();
+
+// Oldest first
+std::vector<Entry> getRecent(size_t count);
+
+// These are safe to call from a signal handler
+void dump(int fd);
+void writeCrashReport(int fd, int signal, void* const* frames, int numFrames);
+}  // namespace FlightRecorder
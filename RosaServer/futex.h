@@ -0,0 +1,29 @@
+#pragma once
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+
+// Blocks while *word == expected, until woken or timeoutMs passes (negative
+// waits forever). May return spuriously.
+inline void futexWait(std::atomic_uint32_t* word, uint32_t expected,
+                      int timeoutMs) {
+	timespec timeout;
+	if (timeoutMs >= 0) {
+		timeout.tv_sec = timeoutMs / 1000;
+		timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+	}
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE,
+	        expected, timeoutMs >= 0 ? &timeout : nullptr, nullptr, 0);
+}
+
+inline void futexWake(std::atomic_uint32_t* word, int count) {
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE,
+	        count, nullptr, nullptr, 0);
+}
+
+inline void futexWakeAll(std::atomic_uint32_t* word) { futexWake(word, INT_MAX); }
@@ -1,6 +1,12 @@
 #include "hooks.h"
 #include "api.h"
+#include "bonehistory.h"
 #include "console.h"
+#include "flightrecorder.h"
+#include "httpclient.h"
+#include "httpserver.h"
+#include "luaerrors.h"
+#include "worldsnapshot.h"
 
 namespace Hooks {
 subhook::Hook subRosaPutsHook;
@@ -111,7 +117,26 @@ void resetGame() {
 	}
 }
 
+static double lastPhysicsSeconds = 0.0;
+static std::chrono::steady_clock::time_point lastLogicStart;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+	                                     start)
+	    .count();
+}
+
 void logicSimulation() {
+	FlightRecorder::nextTick();
+	FlightRecorder::Scope record("Logic");
+
+	auto logicStart = std::chrono::steady_clock::now();
+	double intervalSeconds =
+	    lastLogicStart.time_since_epoch().count()
+	        ? std::chrono::duration<double>(logicStart - lastLogicStart).count()
+	        : 0.0;
+	lastLogicStart = logicStart;
+
 	if (shouldReset) {
 		shouldReset = false;
 		luaInit(true);
@@ -157,6 +182,10 @@ void logicSimulation() {
 		}
 	}
 
+	HTTPClient::drainResponses();
+	JobPool::drainCompletions();
+	LuaErrors::flushSummaries();
+
 	if (Console::isAwaitingAutoComplete()) {
 		if (hookFunc != sol::nil) {
 			auto data = lua->create_table();
@@ -171,242 +200,266 @@ void logicSimulation() {
 			Console::respondToAutoComplete(Console::getAutoCompleteInput());
 		}
 	}
+
+	HTTPServer::handleRoutes();
+	HTTPServer::publish(
+	    {secondsSince(logicStart), lastPhysicsSeconds, intervalSeconds});
 }
 
 void logicSimulationRace() {
+	FlightRecorder::Scope record("LogicRace");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("LogicRace")) {
 		auto res = func("LogicRace");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "LogicRace")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&logicSimulationRaceHook);
 			Engine::logicSimulationRace();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostLogicRace")) {
 			auto res = func("PostLogicRace");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostLogicRace");
 		}
 	}
 }
 
 void logicSimulationRound() {
+	FlightRecorder::Scope record("LogicRound");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("LogicRound")) {
 		auto res = func("LogicRound");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "LogicRound")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&logicSimulationRoundHook);
 			Engine::logicSimulationRound();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostLogicRound")) {
 			auto res = func("PostLogicRound");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostLogicRound");
 		}
 	}
 }
 
 void logicSimulationWorld() {
+	FlightRecorder::Scope record("LogicWorld");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("LogicWorld")) {
 		auto res = func("LogicWorld");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "LogicWorld")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&logicSimulationWorldHook);
 			Engine::logicSimulationWorld();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostLogicWorld")) {
 			auto res = func("PostLogicWorld");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostLogicWorld");
 		}
 	}
 }
 
 void logicSimulationTerminator() {
+	FlightRecorder::Scope record("LogicTerminator");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("LogicTerminator")) {
 		auto res = func("LogicTerminator");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "LogicTerminator")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&logicSimulationTerminatorHook);
 			Engine::logicSimulationTerminator();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostLogicTerminator")) {
 			auto res = func("PostLogicTerminator");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostLogicTerminator");
 		}
 	}
 }
 
 void logicSimulationCoop() {
+	FlightRecorder::Scope record("LogicCoop");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("LogicCoop")) {
 		auto res = func("LogicCoop");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "LogicCoop")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&logicSimulationCoopHook);
 			Engine::logicSimulationCoop();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostLogicCoop")) {
 			auto res = func("PostLogicCoop");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostLogicCoop");
 		}
 	}
 }
 
 void logicSimulationVersus() {
+	FlightRecorder::Scope record("LogicVersus");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("LogicVersus")) {
 		auto res = func("LogicVersus");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "LogicVersus")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&logicSimulationVersusHook);
 			Engine::logicSimulationVersus();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostLogicVersus")) {
 			auto res = func("PostLogicVersus");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostLogicVersus");
 		}
 	}
 }
 
 void logicPlayerActions(int playerID) {
+	FlightRecorder::Scope record("PlayerActions", playerID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PlayerActions")) {
 		auto res = func("PlayerActions", &Engine::players[playerID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "PlayerActions")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&logicPlayerActionsHook);
 			Engine::logicPlayerActions(playerID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostPlayerActions")) {
 			auto res = func("PostPlayerActions", &Engine::players[playerID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPlayerActions");
 		}
 	}
 }
 
 void itemWeaponSimulation(int itemID) {
+	FlightRecorder::Scope record("ItemWeaponSimulation", itemID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("ItemWeaponSimulation")) {
 		auto res = func("ItemWeaponSimulation", &Engine::items[itemID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "ItemWeaponSimulation")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&itemWeaponSimulationHook);
 			Engine::itemWeaponSimulation(itemID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostItemWeaponSimulation")) {
 			auto res = func("PostItemWeaponSimulation", &Engine::items[itemID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostItemWeaponSimulation");
 		}
 	}
 }
 
 void trainSimulation(int vehicleID) {
+	FlightRecorder::Scope record("TrainSimulation", vehicleID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("TrainSimulation")) {
 		auto res = func("TrainSimulation", &Engine::vehicles[vehicleID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "TrainSimulation")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&trainSimulationHook);
 			Engine::trainSimulation(vehicleID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostTrainSimulation")) {
 			auto res = func("PostTrainSimulation", &Engine::vehicles[vehicleID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostTrainSimulation");
 		}
 	}
 }
 
 void humanCalculateArmAngles(int humanID) {
+	FlightRecorder::Scope record("HumanArmAngles", humanID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("HumanArmAngles")) {
 		auto res = func("HumanArmAngles", &Engine::humans[humanID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "HumanArmAngles")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&humanCalculateArmAnglesHook);
 			Engine::humanCalculateArmAngles(humanID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostHumanArmAngles")) {
 			auto res = func("PostHumanArmAngles", &Engine::humans[humanID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostHumanArmAngles");
 		}
 	}
 }
 
 void humanCollideHuman(int humanID) {
+	FlightRecorder::Scope record("HumanCollideHuman", humanID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("HumanCollideHuman")) {
 		auto res = func("HumanCollideHuman", &Engine::humans[humanID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "HumanCollideHuman")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&humanCollideHumanHook);
 			Engine::humanCollideHuman(humanID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostHumanCollideHuman")) {
 			auto res = func("PostHumanCollideHuman", &Engine::humans[humanID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostHumanCollideHuman");
 		}
 	}
 }
 
 void physicsSimulation() {
+	FlightRecorder::Scope record("Physics");
+
+	auto physicsStart = std::chrono::steady_clock::now();
+
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("Physics")) {
 		auto res = func("Physics");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "Physics")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&physicsSimulationHook);
 			Engine::physicsSimulation();
 		}
-		if (func != sol::nil) {
+		BoneHistory::record();
+		WorldSnapshot::publish();
+		if (func != sol::nil && LuaErrors::isEnabled("PostPhysics")) {
 			auto res = func("PostPhysics");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPhysics");
 		}
 	}
+
+	lastPhysicsSeconds = secondsSince(physicsStart);
 }
 
 int serverReceive() {
+	FlightRecorder::Scope record("ServerReceive");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("ServerReceive")) {
 		auto res = func("ServerReceive");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "ServerReceive")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		int ret;
@@ -414,9 +467,9 @@ int serverReceive() {
 			subhook::ScopedHookRemove remove(&serverReceiveHook);
 			ret = Engine::serverReceive();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostServerReceive")) {
 			auto res = func("PostServerReceive");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostServerReceive");
 		}
 		return ret;
 	}
@@ -424,164 +477,173 @@ int serverReceive() {
 }
 
 void serverSend() {
+	FlightRecorder::Scope record("ServerSend");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("ServerSend")) {
 		auto res = func("ServerSend");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "ServerSend")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&serverSendHook);
 			Engine::serverSend();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostServerSend")) {
 			auto res = func("PostServerSend");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostServerSend");
 		}
 	}
 }
 
 void writePacket(int connectionID, int playerID) {
+	FlightRecorder::Scope record("PackObjectPacket", connectionID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PackObjectPacket")) {
 		auto res = func("PackObjectPacket", &Engine::connections[connectionID],&Engine::players[playerID]);
-		noLuaCallError(&res);
+		noLuaCallError(&res, "PackObjectPacket");
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&writePacketHook);
 			Engine::writePacket(connectionID, playerID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostPackObjectPacket")) {
 			auto res = func("PostPackObjectPacket", &Engine::connections[connectionID],&Engine::players[playerID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPackObjectPacket");
 		}
 	}
 }
 
 void sendPacket(unsigned int address, unsigned short port) {
+	FlightRecorder::Scope record("SendPacket");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
 	auto addressString = addressFromInteger(address);
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("SendPacket")) {
 		auto res = func("SendPacket",addressString, port);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "SendPacket")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&sendPacketHook);
 			Engine::sendPacket(address, port);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostSendPacket")) {
 			auto res = func("PostSendPacket", addressString, port);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostSendPacket");
 		}
 	}
 }
 
 void bulletSimulation() {
+	FlightRecorder::Scope record("PhysicsBullets");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PhysicsBullets")) {
 		auto res = func("PhysicsBullets");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "PhysicsBullets")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&bulletSimulationHook);
 			Engine::bulletSimulation();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostPhysicsBullets")) {
 			auto res = func("PostPhysicsBullets");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPhysicsBullets");
 		}
 	}
 }
 
 void bondSimulation() {
+	FlightRecorder::Scope record("PhysicsBonds");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PhysicsBonds")) {
 		auto res = func("PhysicsBonds");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "PhysicsBonds")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&bondSimulationHook);
 			Engine::bondSimulation();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostPhysicsBonds")) {
 			auto res = func("PostPhysicsBonds");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPhysicsBonds");
 		}
 	}
 }
 
 void vehicleSimulation() {
+	FlightRecorder::Scope record("PhysicsVehicles");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PhysicsVehicles")) {
 		auto res = func("PhysicsVehicles");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "PhysicsVehicles")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&vehicleSimulationHook);
 			Engine::vehicleSimulation();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostPhysicsVehicles")) {
 			auto res = func("PostPhysicsVehicles");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPhysicsVehicles");
 		}
 	}
 }
 
 void economyCarMarket() {
+	FlightRecorder::Scope record("EconomyCarMarket");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EconomyCarMarket")) {
 		auto res = func("EconomyCarMarket");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EconomyCarMarket")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&economyCarMarketHook);
 			Engine::economyCarMarket();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEconomyCarMarket")) {
 			auto res = func("PostEconomyCarMarket");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEconomyCarMarket");
 		}
 	}
 }
 
 void saveAccountsServer() {
+	FlightRecorder::Scope record("AccountsSave");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("AccountsSave")) {
 		auto res = func("AccountsSave");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "AccountsSave")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&saveAccountsServerHook);
 			Engine::saveAccountsServer();
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostAccountsSave")) {
 			auto res = func("PostAccountsSave");
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostAccountsSave");
 		}
 	}
 }
 
 int createAccountByJoinTicket(int identifier, unsigned int ticket) {
+	FlightRecorder::Scope record("AccountTicketBegin");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("AccountTicketBegin")) {
 		auto res = func("AccountTicketBegin", identifier, ticket);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "AccountTicketBegin")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		int id;
@@ -589,16 +651,18 @@ int createAccountByJoinTicket(int identifier, unsigned int ticket) {
 			subhook::ScopedHookRemove remove(&createAccountByJoinTicketHook);
 			id = Engine::createAccountByJoinTicket(identifier, ticket);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("AccountTicketFound")) {
 			auto res = func("AccountTicketFound",
 			                id == -1 ? nullptr : &Engine::accounts[id]);
 			noParent = false;
-			if (noLuaCallError(&res)) noParent = (bool)res;
+			if (noLuaCallError(&res, "AccountTicketFound")) noParent = (bool)res;
 
 			if (!noParent) {
-				auto res = func("PostAccountTicket",
-				                id == -1 ? nullptr : &Engine::accounts[id]);
-				noLuaCallError(&res);
+				if (LuaErrors::isEnabled("PostAccountTicket")) {
+					auto res = func("PostAccountTicket",
+					                id == -1 ? nullptr : &Engine::accounts[id]);
+					noLuaCallError(&res, "PostAccountTicket");
+				}
 				return id;
 			}
 			return -1;
@@ -610,6 +674,7 @@ int createAccountByJoinTicket(int identifier, unsigned int ticket) {
 
 void serverSendConnectResponse(unsigned int address, unsigned int port,
                                const char* message) {
+	FlightRecorder::Scope record("SendConnectResponse");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
 
@@ -619,9 +684,9 @@ void serverSendConnectResponse(unsigned int address, unsigned int port,
 	data["message"] = message;
 	std::string newMessage;
 
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("SendConnectResponse")) {
 		auto res = func("SendConnectResponse", addressString, port, data);
-		if (noLuaCallError(&res)) {
+		if (noLuaCallError(&res, "SendConnectResponse")) {
 			noParent = (bool)res;
 			newMessage = data["message"];
 			message = newMessage.c_str();
@@ -632,19 +697,20 @@ void serverSendConnectResponse(unsigned int address, unsigned int port,
 			subhook::ScopedHookRemove remove(&serverSendConnectResponseHook);
 			Engine::serverSendConnectResponse(address, port, message);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostSendConnectResponse")) {
 			auto res = func("PostSendConnectResponse", addressString, port, data);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostSendConnectResponse");
 		}
 	}
 }
 
 int createPlayer() {
+	FlightRecorder::Scope record("PlayerCreate");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PlayerCreate")) {
 		auto res = func("PlayerCreate");
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "PlayerCreate")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		int id;
@@ -657,9 +723,10 @@ int createPlayer() {
 				playerDataTables[id] = nullptr;
 			}
 		}
-		if (func != sol::nil && id != -1) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostPlayerCreate") &&
+		    id != -1) {
 			auto res = func("PostPlayerCreate", &Engine::players[id]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPlayerCreate");
 		}
 		return id;
 	}
@@ -667,11 +734,12 @@ int createPlayer() {
 }
 
 void deletePlayer(int playerID) {
+	FlightRecorder::Scope record("PlayerDelete", playerID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PlayerDelete")) {
 		auto res = func("PlayerDelete", &Engine::players[playerID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "PlayerDelete")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
@@ -683,19 +751,20 @@ void deletePlayer(int playerID) {
 				playerDataTables[playerID] = nullptr;
 			}
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostPlayerDelete")) {
 			auto res = func("PostPlayerDelete", &Engine::players[playerID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPlayerDelete");
 		}
 	}
 }
 
 int createHuman(Vector* pos, RotMatrix* rot, int playerID) {
+	FlightRecorder::Scope record("HumanCreate");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("HumanCreate")) {
 		auto res = func("HumanCreate", pos, rot, &Engine::players[playerID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "HumanCreate")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		int id;
@@ -707,10 +776,12 @@ int createHuman(Vector* pos, RotMatrix* rot, int playerID) {
 				delete humanDataTables[id];
 				humanDataTables[id] = nullptr;
 			}
+			if (id != -1) BoneHistory::forget(id);
 		}
-		if (func != sol::nil && id != -1) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostHumanCreate") &&
+		    id != -1) {
 			auto res = func("PostHumanCreate", &Engine::humans[id]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostHumanCreate");
 		}
 		return id;
 	}
@@ -718,11 +789,12 @@ int createHuman(Vector* pos, RotMatrix* rot, int playerID) {
 }
 
 void deleteHuman(int humanID) {
+	FlightRecorder::Scope record("HumanDelete", humanID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("HumanDelete")) {
 		auto res = func("HumanDelete", &Engine::humans[humanID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "HumanDelete")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
@@ -734,19 +806,20 @@ void deleteHuman(int humanID) {
 				humanDataTables[humanID] = nullptr;
 			}
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostHumanDelete")) {
 			auto res = func("PostHumanDelete", &Engine::humans[humanID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostHumanDelete");
 		}
 	}
 }
 
 int createItem(int type, Vector* pos, Vector* vel, RotMatrix* rot) {
+	FlightRecorder::Scope record("ItemCreate");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("ItemCreate")) {
 		auto res = func("ItemCreate", type, pos, rot);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "ItemCreate")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		int id;
@@ -759,9 +832,10 @@ int createItem(int type, Vector* pos, Vector* vel, RotMatrix* rot) {
 				itemDataTables[id] = nullptr;
 			}
 		}
-		if (id != -1 && func != sol::nil) {
+		if (id != -1 && func != sol::nil &&
+		    LuaErrors::isEnabled("PostItemCreate")) {
 			auto res = func("PostItemCreate", &Engine::items[id]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostItemCreate");
 		}
 		return id;
 	}
@@ -769,11 +843,12 @@ int createItem(int type, Vector* pos, Vector* vel, RotMatrix* rot) {
 }
 
 void deleteItem(int itemID) {
+	FlightRecorder::Scope record("ItemDelete", itemID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("ItemDelete")) {
 		auto res = func("ItemDelete", &Engine::items[itemID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "ItemDelete")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
@@ -785,19 +860,20 @@ void deleteItem(int itemID) {
 				itemDataTables[itemID] = nullptr;
 			}
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostItemDelete")) {
 			auto res = func("PostItemDelete", &Engine::items[itemID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostItemDelete");
 		}
 	}
 }
 
 int createBullet(int type, Vector* pos, Vector* vel, int playerID) {
+	FlightRecorder::Scope record("BulletCreate");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("BulletCreate")) {
 		auto res = func("BulletCreate", type, pos, vel, &Engine::players[playerID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "BulletCreate")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		int id;
@@ -805,9 +881,10 @@ int createBullet(int type, Vector* pos, Vector* vel, int playerID) {
 			subhook::ScopedHookRemove remove(&createBulletHook);
 			id = Engine::createBullet(type, pos, vel, playerID);
 		}
-		if (func != sol::nil && id != -1) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostBulletCreate") &&
+		    id != -1) {
 			auto res = func("PostBulletCreate", &Engine::bullets[id]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostBulletCreate");
 		}
 		return id;
 	}
@@ -815,31 +892,33 @@ int createBullet(int type, Vector* pos, Vector* vel, int playerID) {
 }
 
 void createEventCreateVehicle(int vehicleID) {
+	FlightRecorder::Scope record("EventVehicleCreate", vehicleID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EventVehicleCreate")) {
 		auto res = func("EventVehicleCreate", &Engine::vehicles[vehicleID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EventVehicleCreate")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&createEventCreateVehicleHook);
 			Engine::createEventCreateVehicle(vehicleID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEventVehicleCreate")) {
 			auto res = func("PostEventVehicleCreate", &Engine::vehicles[vehicleID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEventVehicleCreate");
 		}
 	}
 }
 
 int createVehicle(int type, Vector* pos, Vector* vel, RotMatrix* rot,
                   int color) {
+	FlightRecorder::Scope record("VehicleCreate");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("VehicleCreate")) {
 		auto res = func("VehicleCreate", &Engine::vehicleTypes[type], pos, rot, color);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "VehicleCreate")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		int id;
@@ -852,9 +931,10 @@ int createVehicle(int type, Vector* pos, Vector* vel, RotMatrix* rot,
 				vehicleDataTables[id] = nullptr;
 			}
 		}
-		if (id != -1 && func != sol::nil) {
+		if (id != -1 && func != sol::nil &&
+		    LuaErrors::isEnabled("PostVehicleCreate")) {
 			auto res = func("PostVehicleCreate", &Engine::vehicles[id]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostVehicleCreate");
 		}
 		return id;
 	}
@@ -862,11 +942,12 @@ int createVehicle(int type, Vector* pos, Vector* vel, RotMatrix* rot,
 }
 
 void deleteVehicle(int vehicleID) {
+	FlightRecorder::Scope record("VehicleDelete", vehicleID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("VehicleDelete")) {
 		auto res = func("VehicleDelete", &Engine::vehicles[vehicleID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "VehicleDelete")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
@@ -878,28 +959,29 @@ void deleteVehicle(int vehicleID) {
 				vehicleDataTables[vehicleID] = nullptr;
 			}
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostVehicleDelete")) {
 			auto res = func("PostVehicleDelete", &Engine::vehicles[vehicleID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostVehicleDelete");
 		}
 	}
 }
 
 void createTraffic(int count) {
+	FlightRecorder::Scope record("CreateTraffic");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("CreateTraffic")) {
 		auto res = func("CreateTraffic", count);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "CreateTraffic")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&createTrafficHook);
 			Engine::createTraffic(count);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostCreateTraffic")) {
 			auto res = func("PostCreateTraffic", count);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostCreateTraffic");
 		}
 	}
 }
@@ -918,14 +1000,15 @@ int createParticle(int unk, int type, Vector* pos, Vector* vel, int veh) {
 }
 
 int linkItem(int itemID, int childItemID, int parentHumanID, int slot) {
+	FlightRecorder::Scope record("ItemLink", itemID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("ItemLink")) {
 		auto res = func(
 		    "ItemLink", &Engine::items[itemID],
 		    childItemID == -1 ? nullptr : &Engine::items[childItemID],
 		    parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID], slot);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "ItemLink")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		int worked;
@@ -933,13 +1016,13 @@ int linkItem(int itemID, int childItemID, int parentHumanID, int slot) {
 			subhook::ScopedHookRemove remove(&linkItemHook);
 			worked = Engine::linkItem(itemID, childItemID, parentHumanID, slot);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostItemLink")) {
 			auto res =
 			    func("PostItemLink", &Engine::items[itemID],
 			         childItemID == -1 ? nullptr : &Engine::items[childItemID],
 			         parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID],
 			         slot, (bool)worked);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostItemLink");
 		}
 		return worked;
 	}
@@ -947,81 +1030,85 @@ int linkItem(int itemID, int childItemID, int parentHumanID, int slot) {
 }
 
 void itemComputerInput(int itemID, unsigned int character) {
+	FlightRecorder::Scope record("ItemComputerInput", itemID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("ItemComputerInput")) {
 		auto res = func("ItemComputerInput", &Engine::items[itemID], character);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "ItemComputerInput")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&itemComputerInputHook);
 			Engine::itemComputerInput(itemID, character);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostItemComputerInput")) {
 			auto res =
 			    func("PostItemComputerInput", &Engine::items[itemID], character);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostItemComputerInput");
 		}
 	}
 }
 
 void humanApplyDamage(int humanID, int bone, int unk, int damage) {
+	FlightRecorder::Scope record("HumanDamage", humanID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("HumanDamage")) {
 		auto res = func("HumanDamage", &Engine::humans[humanID], bone, damage);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "HumanDamage")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&humanApplyDamageHook);
 			Engine::humanApplyDamage(humanID, bone, unk, damage);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostHumanDamage")) {
 			auto res =
 			    func("PostHumanDamage", &Engine::humans[humanID], bone, damage);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostHumanDamage");
 		}
 	}
 }
 
 void humanCollisionVehicle(int humanID, int vehicleID) {
+	FlightRecorder::Scope record("HumanCollisionVehicle", humanID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("HumanCollisionVehicle")) {
 		auto res = func("HumanCollisionVehicle", &Engine::humans[humanID],
 		                &Engine::vehicles[vehicleID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "HumanCollisionVehicle")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&humanCollisionVehicleHook);
 			Engine::humanCollisionVehicle(humanID, vehicleID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostHumanCollisionVehicle")) {
 			auto res = func("PostHumanCollisionVehicle", &Engine::humans[humanID],
 			                &Engine::vehicles[vehicleID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostHumanCollisionVehicle");
 		}
 	}
 }
 
 void vehicleApplyDamage(int vehicleID, int damage) {
+	FlightRecorder::Scope record("VehicleDamage", vehicleID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("VehicleDamage")) {
 		auto res = func("VehicleDamage", &Engine::vehicles[vehicleID], damage);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "VehicleDamage")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&vehicleApplyDamageHook);
 			Engine::vehicleApplyDamage(vehicleID, damage);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostVehicleDamage")) {
 			auto res = func("PostVehicleDamage", &Engine::vehicles[vehicleID], damage);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostVehicleDamage");
 		}
 	}
 }
@@ -1050,30 +1137,32 @@ void vehicleApplyDamage(int vehicleID, int damage) {
 //}
 
 void grenadeExplosion(int itemID) {
+	FlightRecorder::Scope record("GrenadeExplode", itemID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("GrenadeExplode")) {
 		auto res = func("GrenadeExplode", &Engine::items[itemID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "GrenadeExplode")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&grenadeExplosionHook);
 			Engine::grenadeExplosion(itemID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostGrenadeExplode")) {
 			auto res = func("PostGrenadeExplode", &Engine::items[itemID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostGrenadeExplode");
 		}
 	}
 }
 
 int serverPlayerMessage(int playerID, char* message) {
+	FlightRecorder::Scope record("PlayerChat", playerID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PlayerChat")) {
 		auto res = func("PlayerChat", &Engine::players[playerID], message);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "PlayerChat")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		subhook::ScopedHookRemove remove(&serverPlayerMessageHook);
@@ -1083,39 +1172,41 @@ int serverPlayerMessage(int playerID, char* message) {
 }
 
 void playerAI(int playerID) {
+	FlightRecorder::Scope record("PlayerAI", playerID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PlayerAI")) {
 		auto res = func("PlayerAI", &Engine::players[playerID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "PlayerAI")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&playerAIHook);
 			Engine::playerAI(playerID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostPlayerAI")) {
 			auto res = func("PostPlayerAI", &Engine::players[playerID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPlayerAI");
 		}
 	}
 }
 
 void playerDeathTax(int playerID) {
+	FlightRecorder::Scope record("PlayerDeathTax", playerID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("PlayerDeathTax")) {
 		auto res = func("PlayerDeathTax", &Engine::players[playerID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "PlayerDeathTax")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&playerDeathTaxHook);
 			Engine::playerDeathTax(playerID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostPlayerDeathTax")) {
 			auto res = func("PostPlayerDeathTax", &Engine::players[playerID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostPlayerDeathTax");
 		}
 	}
 }
@@ -1124,13 +1215,14 @@ void addCollisionRigidBodyOnRigidBody(int aBodyID, int bBodyID,
                                       Vector* aLocalPos, Vector* bLocalPos,
                                       Vector* normal, float a, float b, float c,
                                       float d) {
+	FlightRecorder::Scope record("CollideBodies", aBodyID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("CollideBodies")) {
 		auto res = func("CollideBodies", &Engine::particles[aBodyID],
 		                &Engine::particles[bBodyID], aLocalPos, bLocalPos, normal, a,
 		                b, c, d);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "CollideBodies")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		subhook::ScopedHookRemove remove(&addCollisionRigidBodyOnRigidBodyHook);
@@ -1152,109 +1244,115 @@ Type:
 */
 void createEventMessage(int speakerType, char* message, int speakerID,
                         int distance) {
+	FlightRecorder::Scope record("EventMessage");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EventMessage")) {
 		auto res = func("EventMessage", speakerType, message, speakerID, distance);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EventMessage")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&createEventMessageHook);
 			Engine::createEventMessage(speakerType, message, speakerID, distance);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEventMessage")) {
 			auto res =
 			    func("PostEventMessage", speakerType, message, speakerID, distance);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEventMessage");
 		}
 	}
 }
 
 void createEventUpdatePlayer(int id) {
+	FlightRecorder::Scope record("EventUpdatePlayer", id);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EventUpdatePlayer")) {
 		auto res = func("EventUpdatePlayer", &Engine::players[id]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EventUpdatePlayer")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&createEventUpdatePlayerHook);
 			Engine::createEventUpdatePlayer(id);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEventUpdatePlayer")) {
 			auto res = func("PostEventUpdatePlayer", &Engine::players[id]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEventUpdatePlayer");
 		}
 	}
 }
 
 void createEventUpdateHuman(int id) {
+	FlightRecorder::Scope record("EventUpdateHuman", id);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EventUpdateHuman")) {
 		auto res = func("EventUpdateHuman", &Engine::humans[id]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EventUpdateHuman")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&createEventUpdateHumanHook);
 			Engine::createEventUpdateHuman(id);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEventUpdateHuman")) {
 			auto res = func("PostEventUpdateHuman", &Engine::humans[id]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEventUpdateHuman");
 		}
 	}
 }
 
 void createEventUpdateItem(int id) {
+	FlightRecorder::Scope record("EventUpdateItem", id);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EventUpdateItem")) {
 		auto res = func("EventUpdateItem", &Engine::items[id]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EventUpdateItem")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&createEventUpdateItemHook);
 			Engine::createEventUpdateItem(id);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEventUpdateItem")) {
 			auto res = func("PostEventUpdateItem", &Engine::items[id]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEventUpdateItem");
 		}
 	}
 }
 
 void createEventUpdateItemInfo(int id) {
+	FlightRecorder::Scope record("EventUpdateItemInfo", id);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EventUpdateItemInfo")) {
 		auto res = func("EventUpdateItemInfo", &Engine::items[id]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EventUpdateItemInfo")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&createEventUpdateItemInfoHook);
 			Engine::createEventUpdateItemInfo(id);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEventUpdateItemInfo")) {
 			auto res = func("PostEventUpdateItemInfo", &Engine::items[id]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEventUpdateItemInfo");
 		}
 	}
 }
 
 void createEventUpdateVehicle(int vehicleID, int updateType, int partID,
                               Vector* pos, Vector* normal) {
+	FlightRecorder::Scope record("EventUpdateVehicle", vehicleID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EventUpdateVehicle")) {
 		auto res = func("EventUpdateVehicle", &Engine::vehicles[vehicleID],
 		                updateType, partID, pos, normal);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EventUpdateVehicle")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
@@ -1262,53 +1360,57 @@ void createEventUpdateVehicle(int vehicleID, int updateType, int partID,
 			Engine::createEventUpdateVehicle(vehicleID, updateType, partID, pos,
 			                                 normal);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEventUpdateVehicle")) {
 			auto res = func("PostEventUpdateVehicle", &Engine::vehicles[vehicleID],
 			                updateType, partID, pos, normal);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEventUpdateVehicle");
 		}
 	}
 }
 
 void createEventBulletHit(int unk, int hitType, Vector* pos, Vector* normal) {
+	FlightRecorder::Scope record("EventBulletHit");
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EventBulletHit")) {
 		auto res = func("EventBulletHit", hitType, pos, normal);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EventBulletHit")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&createEventBulletHitHook);
 			Engine::createEventBulletHit(unk, hitType, pos, normal);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEventBulletHit")) {
 			auto res = func("PostEventBulletHit", hitType, pos, normal);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEventBulletHit");
 		}
 	}
 }
 
 void createEventBullet(int bulletType, Vector* pos, Vector* vel, int itemID) {
+	FlightRecorder::Scope record("EventBullet", itemID);
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("EventBullet")) {
 		auto res = func("EventBullet", bulletType, pos, vel, &Engine::items[itemID]);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "EventBullet")) noParent = (bool)res;
 	}
 	if (!noParent) {
 		{
 			subhook::ScopedHookRemove remove(&createEventBulletHook);
 			Engine::createEventBullet(bulletType, pos, vel, itemID);
 		}
-		if (func != sol::nil) {
+		if (func != sol::nil && LuaErrors::isEnabled("PostEventBullet")) {
 			auto res = func("PostEventBullet", bulletType, pos, vel, &Engine::items[itemID]);
-			noLuaCallError(&res);
+			noLuaCallError(&res, "PostEventBullet");
 		}
 	}
 }
 
 int lineIntersectHuman(int humanID, Vector* posA, Vector* posB) {
+	FlightRecorder::Scope record("LineIntersectHuman", humanID);
+
 	int didHit;
 	{
 		subhook::ScopedHookRemove remove(&lineIntersectHumanHook);
@@ -1321,9 +1423,9 @@ int lineIntersectHuman(int humanID, Vector* posA, Vector* posB) {
 
 	bool noParent = false;
 	sol::protected_function func = (*lua)["hook"]["run"];
-	if (func != sol::nil) {
+	if (func != sol::nil && LuaErrors::isEnabled("LineIntersectHuman")) {
 		auto res = func("LineIntersectHuman", &Engine::humans[humanID], posA, posB);
-		if (noLuaCallError(&res)) noParent = (bool)res;
+		if (noLuaCallError(&res, "LineIntersectHuman")) noParent = (bool)res;
 	}
 
 	return !noParent;
@@ -0,0 +1,455 @@
+#include "httpclient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+namespace HTTPClient {
+static constexpr unsigned int numThreads = 4;
+static constexpr const char* callbackTableKey = "RosaServer.httpCallbacks";
+static constexpr size_t uploadChunkSize = 64 * 1024;
+static constexpr std::chrono::milliseconds progressInterval(100);
+
+static std::deque<LuaHTTPRequest> requestQueue;
+static std::mutex requestQueueMutex;
+static std::condition_variable requestQueueCondition;
+
+static std::deque<LuaHTTPResponse> responseQueue;
+static std::mutex responseQueueMutex;
+
+static bool threadsStarted = false;
+static uint64_t nextCallbackID = 1;
+static unsigned int numInFlight = 0;
+static unsigned int callbackBudget = 32;
+static unsigned int maxInFlight = 256;
+
+// Clients per scheme+host, each used by one request at a time
+struct IdleClient {
+	std::unique_ptr<httplib::Client> client;
+	std::chrono::steady_clock::time_point lastUsed;
+};
+
+struct PoolHost {
+	std::vector<IdleClient> idle;
+	unsigned int numActive = 0;
+};
+
+static std::unordered_map<std::string, PoolHost> poolHosts;
+static std::mutex poolMutex;
+static std::condition_variable poolCondition;
+
+static unsigned int maxConnectionsPerHost = 8;
+static std::chrono::seconds idleTimeout(30);
+static uint64_t poolHits = 0;
+static uint64_t poolMisses = 0;
+static uint64_t poolEvictions = 0;
+
+static void evictIdleClients() {
+	auto now = std::chrono::steady_clock::now();
+	for (auto& pair : poolHosts) {
+		auto& idle = pair.second.idle;
+		auto expired = std::remove_if(idle.begin(), idle.end(), [&](auto& entry) {
+			return now - entry.lastUsed > idleTimeout;
+		});
+		poolEvictions += idle.end() - expired;
+		idle.erase(expired, idle.end());
+	}
+}
+
+static std::unique_ptr<httplib::Client> createClient(
+    const std::string& scheme) {
+	auto client = std::make_unique<httplib::Client>(scheme);
+	client->set_connection_timeout(6);
+	client->set_keep_alive(true);
+	return client;
+}
+
+// Returns nullptr rather than waiting if every client for the host is busy and
+// mayWait is false
+static std::unique_ptr<httplib::Client> acquireClient(const std::string& scheme,
+                                                      bool mayWait = true) {
+	std::unique_lock<std::mutex> lock(poolMutex);
+	evictIdleClients();
+
+	PoolHost& host = poolHosts[scheme];
+	auto isFree = [&] {
+		return !host.idle.empty() ||
+		       host.idle.size() + host.numActive < maxConnectionsPerHost;
+	};
+	if (!mayWait && !isFree()) return nullptr;
+	poolCondition.wait(lock, isFree);
+	host.numActive++;
+
+	if (!host.idle.empty()) {
+		poolHits++;
+		// Most recently used first, as it's the least likely to have timed out
+		auto client = std::move(host.idle.back().client);
+		host.idle.pop_back();
+		return client;
+	}
+
+	poolMisses++;
+	lock.unlock();
+	return createClient(scheme);
+}
+
+static void releaseClient(const std::string& scheme,
+                          std::unique_ptr<httplib::Client> client) {
+	{
+		std::lock_guard<std::mutex> guard(poolMutex);
+		PoolHost& host = poolHosts[scheme];
+		host.numActive--;
+		// A failed request may have left the connection in a bad state
+		if (client)
+			host.idle.push_back({std::move(client), std::chrono::steady_clock::now()});
+	}
+	poolCondition.notify_all();
+}
+
+void splitURL(const std::string& url, std::string& scheme, std::string& path) {
+	auto hostStart = url.find("://");
+	if (hostStart == std::string::npos || hostStart + 3 >= url.size())
+		throw std::invalid_argument("Invalid URL");
+
+	auto pathStart = url.find('/', hostStart + 3);
+	if (pathStart == std::string::npos) {
+		scheme = url;
+		path = "/";
+	} else {
+		scheme = url.substr(0, pathStart);
+		path = url.substr(pathStart);
+	}
+}
+
+static httplib::Result send(httplib::Client& client,
+                            const LuaHTTPRequest& request) {
+	return request.type == LuaRequestType::post
+	           ? client.Post(request.path.c_str(), request.headers, request.body,
+	                         request.contentType.c_str())
+	           : client.Get(request.path.c_str(), request.headers);
+}
+
+httplib::Result perform(const LuaHTTPRequest& request) {
+	auto client = acquireClient(request.scheme);
+	auto res = send(*client, request);
+
+	if (!res) client.reset();
+	releaseClient(request.scheme, std::move(client));
+	return res;
+}
+
+httplib::Result performSync(const LuaHTTPRequest& request) {
+	auto client = acquireClient(request.scheme, false);
+	// Background requests can hold every pooled client for as long as they
+	// like, so make a one-off one instead of waiting for them
+	if (!client) return send(*createClient(request.scheme), request);
+
+	auto res = send(*client, request);
+
+	if (!res) client.reset();
+	releaseClient(request.scheme, std::move(client));
+	return res;
+}
+
+void setPoolLimits(unsigned int maxConnections, unsigned int idleSeconds) {
+	// Nothing could ever be sent
+	if (maxConnections < 1)
+		throw std::invalid_argument("maxConnectionsPerHost must be at least 1");
+
+	{
+		std::lock_guard<std::mutex> guard(poolMutex);
+		maxConnectionsPerHost = maxConnections;
+		idleTimeout = std::chrono::seconds(idleSeconds);
+		evictIdleClients();
+	}
+	poolCondition.notify_all();
+}
+
+PoolStats getPoolStats() {
+	std::lock_guard<std::mutex> guard(poolMutex);
+	evictIdleClients();
+
+	PoolStats stats = {poolHits, poolMisses, poolEvictions, 0, 0};
+	for (const auto& pair : poolHosts) {
+		stats.idle += pair.second.idle.size();
+		stats.active += pair.second.numActive;
+	}
+	return stats;
+}
+
+static void pushResponse(LuaHTTPResponse&& response) {
+	std::lock_guard<std::mutex> guard(responseQueueMutex);
+	responseQueue.push_back(std::move(response));
+}
+
+// Reports how far along a transfer is, at most every progressInterval so a
+// slow tick can't fall far behind
+class TransferProgress {
+	const LuaHTTPRequest& request;
+	std::chrono::steady_clock::time_point lastReported;
+
+ public:
+	uint64_t transferred = 0;
+	uint64_t total = 0;
+
+	TransferProgress(const LuaHTTPRequest& request) : request(request) {}
+
+	void update(uint64_t newTransferred, uint64_t newTotal) {
+		transferred = newTransferred;
+		total = newTotal;
+
+		auto now = std::chrono::steady_clock::now();
+		if (now - lastReported < progressInterval) return;
+		lastReported = now;
+
+		LuaHTTPResponse response;
+		response.callbackID = request.callbackID;
+		response.type = request.type;
+		response.responded = false;
+		response.done = false;
+		response.transferred = transferred;
+		response.total = total;
+		pushResponse(std::move(response));
+	}
+
+	void fail(std::string&& error) {
+		LuaHTTPResponse response;
+		response.callbackID = request.callbackID;
+		response.type = request.type;
+		response.responded = false;
+		response.transferred = transferred;
+		response.total = total;
+		response.error = std::move(error);
+		pushResponse(std::move(response));
+	}
+
+	void finish(httplib::Result& res, std::string&& error) {
+		if (!res) {
+			fail("Request failed (error " +
+			     std::to_string(static_cast<int>(res.error())) + ")");
+			return;
+		}
+
+		LuaHTTPResponse response;
+		response.callbackID = request.callbackID;
+		response.type = request.type;
+		response.responded = true;
+		response.status = res->status;
+		response.transferred = transferred;
+		response.total = total;
+		// Uploads hand back whatever the server replied with
+		if (request.type == LuaRequestType::upload)
+			response.body = std::move(res->body);
+		response.error = std::move(error);
+		pushResponse(std::move(response));
+	}
+};
+
+// Streams into a temporary file next to the destination, which only replaces
+// it once the whole body arrived with a successful status
+static void performDownload(const LuaHTTPRequest& request) {
+	TransferProgress progress(request);
+	std::string partPath = request.filePath + ".part";
+
+	std::ofstream file(partPath, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		progress.fail("Could not open file for writing");
+		return;
+	}
+
+	auto client = acquireClient(request.scheme);
+	auto res = client->Get(
+	    request.path.c_str(), request.headers,
+	    [&](const char* data, size_t length) {
+		    file.write(data, length);
+		    return (bool)file;
+	    },
+	    [&](uint64_t current, uint64_t total) {
+		    progress.update(current, total);
+		    return true;
+	    });
+	file.close();
+
+	if (!res) client.reset();
+	releaseClient(request.scheme, std::move(client));
+
+	std::string error;
+	std::error_code code;
+	if (res && res->status >= 200 && res->status <= 299 && file) {
+		std::filesystem::rename(partPath, request.filePath, code);
+		if (code) error = code.message();
+	} else {
+		if (res && !file) error = "Could not write file";
+		std::filesystem::remove(partPath, code);
+	}
+
+	progress.finish(res, std::move(error));
+}
+
+static void performUpload(const LuaHTTPRequest& request) {
+	TransferProgress progress(request);
+
+	std::ifstream file(request.filePath, std::ios::binary);
+	std::error_code code;
+	auto size = std::filesystem::file_size(request.filePath, code);
+	if (!file || code) {
+		progress.fail("Could not open file for reading");
+		return;
+	}
+
+	auto client = acquireClient(request.scheme);
+	auto res = client->Post(
+	    request.path.c_str(), request.headers, size,
+	    [&](size_t offset, size_t length, httplib::DataSink& sink) {
+		    char buffer[uploadChunkSize];
+		    file.clear();
+		    file.seekg(offset);
+		    file.read(buffer, std::min(length, uploadChunkSize));
+		    if (file.gcount() <= 0) return false;
+
+		    sink.write(buffer, file.gcount());
+		    progress.update(offset + file.gcount(), size);
+		    return true;
+	    },
+	    request.contentType.c_str());
+
+	if (!res) client.reset();
+	releaseClient(request.scheme, std::move(client));
+
+	progress.finish(res, "");
+}
+
+static void threadMain() {
+	while (true) {
+		LuaHTTPRequest request;
+		{
+			std::unique_lock<std::mutex> lock(requestQueueMutex);
+			requestQueueCondition.wait(lock, [] { return !requestQueue.empty(); });
+			request = std::move(requestQueue.front());
+			requestQueue.pop_front();
+		}
+
+		if (request.type == LuaRequestType::download) {
+			performDownload(request);
+			continue;
+		}
+		if (request.type == LuaRequestType::upload) {
+			performUpload(request);
+			continue;
+		}
+
+		LuaHTTPResponse response;
+		response.callbackID = request.callbackID;
+		response.type = request.type;
+
+		auto res = perform(request);
+		response.responded = (bool)res;
+		if (res) {
+			response.status = res->status;
+			response.body = std::move(res->body);
+			response.headers = std::move(res->headers);
+		}
+
+		pushResponse(std::move(response));
+	}
+}
+
+// Kept in the registry of the current state, so they go away with it when the
+// state is reset, and responses for them are simply dropped
+static sol::table getCallbackTable() {
+	sol::table registry = lua->registry();
+	sol::object existing = registry[callbackTableKey];
+	if (existing.is<sol::table>()) return existing;
+
+	sol::table table = lua->create_table();
+	registry[callbackTableKey] = table;
+	return table;
+}
+
+void enqueue(LuaHTTPRequest&& request, sol::protected_function callback) {
+	if (numInFlight >= maxInFlight)
+		throw std::runtime_error("Too many HTTP requests in flight");
+
+	if (!threadsStarted) {
+		threadsStarted = true;
+		for (unsigned int i = 0; i < numThreads; i++) {
+			std::thread thread(threadMain);
+			thread.detach();
+		}
+	}
+
+	request.callbackID = nextCallbackID++;
+	getCallbackTable()[request.callbackID] = callback;
+	numInFlight++;
+
+	{
+		std::lock_guard<std::mutex> guard(requestQueueMutex);
+		requestQueue.push_back(std::move(request));
+	}
+	requestQueueCondition.notify_one();
+}
+
+void drainResponses() {
+	if (!numInFlight) return;
+
+	std::deque<LuaHTTPResponse> responses;
+	{
+		std::lock_guard<std::mutex> guard(responseQueueMutex);
+		unsigned int count = std::min<size_t>(callbackBudget, responseQueue.size());
+		for (unsigned int i = 0; i < count; i++) {
+			responses.push_back(std::move(responseQueue.front()));
+			responseQueue.pop_front();
+		}
+	}
+
+	if (responses.empty()) return;
+
+	sol::table callbacks = getCallbackTable();
+	for (auto& response : responses) {
+		if (response.done) numInFlight--;
+
+		sol::protected_function callback = callbacks[response.callbackID];
+		if (callback == sol::nil) continue;
+		if (response.done) callbacks[response.callbackID] = sol::lua_nil;
+
+		sol::protected_function_result res;
+		if (response.type == LuaRequestType::download ||
+		    response.type == LuaRequestType::upload) {
+			sol::table table = lua->create_table();
+			table["done"] = response.done;
+			table[response.type == LuaRequestType::download ? "received" : "sent"] =
+			    response.transferred;
+			table["total"] = response.total;
+			if (response.responded) table["status"] = response.status;
+			if (!response.body.empty()) table["body"] = std::move(response.body);
+			if (!response.error.empty()) table["error"] = std::move(response.error);
+
+			res = callback(table);
+		} else if (response.responded) {
+			sol::table table = lua->create_table();
+			table["status"] = response.status;
+			table["body"] = std::move(response.body);
+
+			sol::table headers = lua->create_table();
+			for (const auto& h : response.headers) headers[h.first] = h.second;
+			table["headers"] = headers;
+
+			res = callback(table);
+		} else {
+			res = callback(sol::lua_nil);
+		}
+		noLuaCallError(&res);
+	}
+}
+
+void setCallbackBudget(unsigned int budget) { callbackBudget = budget; }
+
+void setMaxInFlight(unsigned int max) { maxInFlight = max; }
+
+unsigned int getNumInFlight() { return numInFlight; }
+}  // namespace HTTPClient
@@ -0,0 +1,35 @@
+#pragma once
+#include "api.h"
+
+// Runs Lua HTTP requests on a pool of background threads. Everything but the
+// worker threads themselves is only used from the tick thread.
+namespace HTTPClient {
+// Throws if too many requests are already in flight
+void enqueue(LuaHTTPRequest&& request, sol::protected_function callback);
+// Calls back for finished requests, up to the per-tick budget
+void drainResponses();
+
+void setCallbackBudget(unsigned int budget);
+void setMaxInFlight(unsigned int max);
+unsigned int getNumInFlight();
+
+struct PoolStats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	unsigned int idle;
+	unsigned int active;
+};
+
+// Splits a full URL into the scheme and host, and the path, throwing if it has
+// no scheme
+void splitURL(const std::string& url, std::string& scheme, std::string& path);
+
+// Performs a request on a pooled keep-alive client, from any thread
+httplib::Result perform(const LuaHTTPRequest& request);
+// Like perform, but never waits for a free client, for the tick thread
+httplib::Result performSync(const LuaHTTPRequest& request);
+void setPoolLimits(unsigned int maxConnectionsPerHost,
+                   unsigned int idleTimeoutSeconds);
+PoolStats getPoolStats();
+}  // namespace HTTPClient
@@ -0,0 +1,350 @@
+#include "httpserver.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <set>
+
+namespace HTTPServer {
+static constexpr const char* routeTableKey = "RosaServer.httpRoutes";
+
+struct Snapshot {
+	uint64_t tick;
+	int gameType;
+	int gameState;
+	unsigned int numConnections;
+	unsigned int numPlayers;
+	unsigned int numBots;
+	unsigned int numHumans;
+	unsigned int numItems;
+	unsigned int numVehicles;
+	unsigned int numBullets;
+	double logicSeconds;
+	double physicsSeconds;
+	double intervalSeconds;
+	uint64_t numLuaErrors;
+};
+
+// Two buffers, each behind a sequence lock: the tick thread fills the one not
+// currently published, so readers only ever retry, and the tick thread never
+// waits on them.
+static Snapshot snapshots[2];
+static std::atomic_uint snapshotVersions[2];
+static std::atomic_int publishedSnapshot(0);
+static uint64_t numTicksPublished = 0;
+
+struct RouteResponse {
+	int status;
+	std::string body;
+	std::string contentType;
+};
+
+struct PendingRequest {
+	std::string key;
+	std::string method;
+	std::string path;
+	std::string body;
+	httplib::Headers headers;
+	std::multimap<std::string, std::string> params;
+	std::chrono::steady_clock::time_point deadline;
+	std::promise<RouteResponse> promise;
+};
+
+static std::set<std::string> routeKeys;
+static std::deque<std::shared_ptr<PendingRequest>> pendingRequests;
+static std::mutex routesMutex;
+static std::atomic_uint handlerTimeoutMs(1000);
+
+static httplib::Server* server = nullptr;
+static std::thread serverThread;
+
+static std::string routeKey(const std::string& method, const std::string& path) {
+	return method + ' ' + path;
+}
+
+void publish(const TickTimings& timings) {
+	if (!server) return;
+
+	int index = 1 - publishedSnapshot.load(std::memory_order_relaxed);
+	auto& version = snapshotVersions[index];
+
+	version.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Snapshot& snapshot = snapshots[index];
+	snapshot.tick = ++numTicksPublished;
+	snapshot.gameType = *Engine::gameType;
+	snapshot.gameState = *Engine::gameState;
+	snapshot.numConnections = *Engine::numConnections;
+	snapshot.numPlayers = 0;
+	snapshot.numBots = 0;
+	for (int i = 0; i < maxNumberOfPlayers; i++) {
+		const Player* ply = &Engine::players[i];
+		if (!ply->active) continue;
+		if (ply->isBot)
+			snapshot.numBots++;
+		else
+			snapshot.numPlayers++;
+	}
+	snapshot.numHumans = 0;
+	for (int i = 0; i < maxNumberOfHumans; i++)
+		if (Engine::humans[i].active) snapshot.numHumans++;
+	snapshot.numItems = 0;
+	for (int i = 0; i < maxNumberOfItems; i++)
+		if (Engine::items[i].active) snapshot.numItems++;
+	snapshot.numVehicles = 0;
+	for (int i = 0; i < maxNumberOfVehicles; i++)
+		if (Engine::vehicles[i].active) snapshot.numVehicles++;
+	snapshot.numBullets = *Engine::numBullets;
+	snapshot.logicSeconds = timings.logicSeconds;
+	snapshot.physicsSeconds = timings.physicsSeconds;
+	snapshot.intervalSeconds = timings.intervalSeconds;
+	snapshot.numLuaErrors = getNumLuaErrors();
+
+	version.fetch_add(1, std::memory_order_release);
+	publishedSnapshot.store(index, std::memory_order_release);
+}
+
+static Snapshot readSnapshot() {
+	while (true) {
+		int index = publishedSnapshot.load(std::memory_order_acquire);
+		unsigned int before =
+		    snapshotVersions[index].load(std::memory_order_acquire);
+		if (before & 1) continue;
+
+		Snapshot copy = snapshots[index];
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (snapshotVersions[index].load(std::memory_order_relaxed) == before)
+			return copy;
+	}
+}
+
+static void serveStatus(const httplib::Request&, httplib::Response& res) {
+	Snapshot s = readSnapshot();
+
+	char buf[1024];
+	snprintf(buf, sizeof(buf),
+	         "{\"tick\":%lu,\"gameType\":%i,\"gameState\":%i,"
+	         "\"connections\":%u,\"players\":%u,\"bots\":%u,\"humans\":%u,"
+	         "\"items\":%u,\"vehicles\":%u,\"bullets\":%u,"
+	         "\"logicSeconds\":%f,\"physicsSeconds\":%f,"
+	         "\"tickIntervalSeconds\":%f,\"luaErrors\":%lu}",
+	         s.tick, s.gameType, s.gameState, s.numConnections, s.numPlayers,
+	         s.numBots, s.numHumans, s.numItems, s.numVehicles, s.numBullets,
+	         s.logicSeconds, s.physicsSeconds, s.intervalSeconds, s.numLuaErrors);
+
+	res.set_content(buf, "application/json");
+}
+
+static void serveMetrics(const httplib::Request&, httplib::Response& res) {
+	Snapshot s = readSnapshot();
+
+	char buf[2048];
+	snprintf(buf, sizeof(buf),
+	         "# TYPE rosaserver_ticks_total counter\n"
+	         "rosaserver_ticks_total %lu\n"
+	         "# TYPE rosaserver_game_state gauge\n"
+	         "rosaserver_game_state %i\n"
+	         "# TYPE rosaserver_connections gauge\n"
+	         "rosaserver_connections %u\n"
+	         "# TYPE rosaserver_players gauge\n"
+	         "rosaserver_players{bot=\"false\"} %u\n"
+	         "rosaserver_players{bot=\"true\"} %u\n"
+	         "# TYPE rosaserver_humans gauge\n"
+	         "rosaserver_humans %u\n"
+	         "# TYPE rosaserver_items gauge\n"
+	         "rosaserver_items %u\n"
+	         "# TYPE rosaserver_vehicles gauge\n"
+	         "rosaserver_vehicles %u\n"
+	         "# TYPE rosaserver_bullets gauge\n"
+	         "rosaserver_bullets %u\n"
+	         "# TYPE rosaserver_logic_seconds gauge\n"
+	         "rosaserver_logic_seconds %f\n"
+	         "# TYPE rosaserver_physics_seconds gauge\n"
+	         "rosaserver_physics_seconds %f\n"
+	         "# TYPE rosaserver_tick_interval_seconds gauge\n"
+	         "rosaserver_tick_interval_seconds %f\n"
+	         "# TYPE rosaserver_lua_errors_total counter\n"
+	         "rosaserver_lua_errors_total %lu\n",
+	         s.tick, s.gameState, s.numConnections, s.numPlayers, s.numBots,
+	         s.numHumans, s.numItems, s.numVehicles, s.numBullets,
+	         s.logicSeconds, s.physicsSeconds, s.intervalSeconds, s.numLuaErrors);
+
+	res.set_content(buf, "text/plain; version=0.0.4");
+}
+
+static void serveLuaRoute(const httplib::Request& req, httplib::Response& res) {
+	auto pending = std::make_shared<PendingRequest>();
+	pending->key = routeKey(req.method, req.path);
+
+	{
+		std::lock_guard<std::mutex> guard(routesMutex);
+		if (!routeKeys.count(pending->key)) {
+			res.status = 404;
+			res.set_content("Not found", "text/plain");
+			return;
+		}
+	}
+
+	pending->method = req.method;
+	pending->path = req.path;
+	pending->body = req.body;
+	pending->headers = req.headers;
+	pending->params = req.params;
+	pending->deadline = std::chrono::steady_clock::now() +
+	                    std::chrono::milliseconds(handlerTimeoutMs.load());
+
+	auto future = pending->promise.get_future();
+	{
+		std::lock_guard<std::mutex> guard(routesMutex);
+		pendingRequests.push_back(pending);
+	}
+
+	if (future.wait_until(pending->deadline) != std::future_status::ready) {
+		res.status = 504;
+		res.set_content("Handler timed out", "text/plain");
+		return;
+	}
+
+	RouteResponse response = future.get();
+	res.status = response.status;
+	res.set_content(response.body, response.contentType.c_str());
+}
+
+bool start(const char* host, int port) {
+	if (server) throw std::runtime_error("Server is already running");
+
+	server = new httplib::Server();
+	server->Get("/status", serveStatus);
+	server->Get("/metrics", serveMetrics);
+	server->Get(".*", serveLuaRoute);
+	server->Post(".*", serveLuaRoute);
+
+	if (!server->bind_to_port(host, port)) {
+		delete server;
+		server = nullptr;
+		return false;
+	}
+
+	serverThread = std::thread([]() { server->listen_after_bind(); });
+	return true;
+}
+
+static void failPendingRequests() {
+	std::lock_guard<std::mutex> guard(routesMutex);
+	for (auto& pending : pendingRequests)
+		pending->promise.set_value({503, "Server stopping", "text/plain"});
+	pendingRequests.clear();
+}
+
+void stop() {
+	if (!server) return;
+
+	server->stop();
+	// Don't leave anything waiting out its deadline, before and after the
+	// worker threads finish
+	failPendingRequests();
+	serverThread.join();
+	failPendingRequests();
+
+	delete server;
+	server = nullptr;
+}
+
+bool isRunning() { return server != nullptr; }
+
+// Handlers are kept in the registry of the current state, so they go away with
+// it when the state is reset
+static sol::table getRouteTable() {
+	sol::table registry = lua->registry();
+	sol::object existing = registry[routeTableKey];
+	if (existing.is<sol::table>()) return existing;
+
+	sol::table table = lua->create_table();
+	registry[routeTableKey] = table;
+	return table;
+}
+
+void addRoute(const char* method, const char* path,
+              sol::protected_function handler) {
+	std::string key = routeKey(method, path);
+	getRouteTable()[key] = handler;
+
+	std::lock_guard<std::mutex> guard(routesMutex);
+	routeKeys.insert(key);
+}
+
+void removeRoute(const char* method, const char* path) {
+	std::string key = routeKey(method, path);
+	getRouteTable()[key] = sol::lua_nil;
+
+	std::lock_guard<std::mutex> guard(routesMutex);
+	routeKeys.erase(key);
+}
+
+void setHandlerTimeout(unsigned int ms) { handlerTimeoutMs = ms; }
+
+static RouteResponse runHandler(sol::protected_function& handler,
+                                const PendingRequest& pending) {
+	sol::table request = lua->create_table();
+	request["method"] = pending.method;
+	request["path"] = pending.path;
+	request["body"] = pending.body;
+
+	sol::table headers = lua->create_table();
+	for (const auto& h : pending.headers) headers[h.first] = h.second;
+	request["headers"] = headers;
+
+	sol::table params = lua->create_table();
+	for (const auto& p : pending.params) params[p.first] = p.second;
+	request["params"] = params;
+
+	auto res = handler(request);
+	if (!noLuaCallError(&res)) return {500, "Internal server error", "text/plain"};
+
+	RouteResponse response = {200, "", "text/plain"};
+
+	sol::object body = res.get<sol::object>(0);
+	if (body.is<std::string>()) response.body = body.as<std::string>();
+
+	if (res.return_count() > 1) {
+		sol::object status = res.get<sol::object>(1);
+		if (status.is<int>()) response.status = status.as<int>();
+	}
+
+	if (res.return_count() > 2) {
+		sol::object contentType = res.get<sol::object>(2);
+		if (contentType.is<std::string>())
+			response.contentType = contentType.as<std::string>();
+	}
+
+	return response;
+}
+
+void handleRoutes() {
+	if (!server) return;
+
+	std::deque<std::shared_ptr<PendingRequest>> requests;
+	{
+		std::lock_guard<std::mutex> guard(routesMutex);
+		if (pendingRequests.empty()) return;
+		requests.swap(pendingRequests);
+	}
+
+	sol::table routes = getRouteTable();
+	for (auto& pending : requests) {
+		// Nobody is waiting for this anymore
+		if (std::chrono::steady_clock::now() > pending->deadline) continue;
+
+		sol::protected_function handler = routes[pending->key];
+		if (handler == sol::nil) {
+			pending->promise.set_value({404, "Not found", "text/plain"});
+			continue;
+		}
+
+		pending->promise.set_value(runHandler(handler, *pending));
+	}
+}
+}  // namespace HTTPServer
@@ -0,0 +1,25 @@
+#pragma once
+#include "api.h"
+
+// Opt-in server for metrics and admin routes. Requests are served on the
+// server's own threads, except Lua routes, which run on the tick thread.
+namespace HTTPServer {
+struct TickTimings {
+	double logicSeconds;
+	double physicsSeconds;
+	double intervalSeconds;
+};
+
+bool start(const char* host, int port);
+void stop();
+bool isRunning();
+
+void addRoute(const char* method, const char* path,
+              sol::protected_function handler);
+void removeRoute(const char* method, const char* path);
+void setHandlerTimeout(unsigned int ms);
+
+// Called from the tick thread once per tick
+void publish(const TickTimings& timings);
+void handleRoutes();
+}  // namespace HTTPServer
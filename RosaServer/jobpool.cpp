@@ -0,0 +1,242 @@
+#include "jobpool.h"
+#include "api.h"
+#include "futex.h"
+#include "serialize.h"
+
+#include <thread>
+
+std::set<JobPool*> JobPool::pools;
+uint64_t JobPool::nextJobID = 1;
+
+JobPool::JobPool(unsigned int numThreads, std::string fileName)
+    : shared(std::make_shared<Shared>()), numThreads(numThreads) {
+	for (unsigned int i = 0; i < numThreads; i++)
+		shared->queues.push_back(std::make_unique<JobQueue>());
+
+	for (unsigned int i = 0; i < numThreads; i++) {
+		std::thread thread(&JobPool::runThread, shared, i, fileName);
+		thread.detach();
+	}
+
+	pools.insert(this);
+}
+
+// Callbacks for jobs that never finished would otherwise stay in the registry
+// for as long as the state lives
+JobPool::~JobPool() {
+	shutdown();
+	releaseCallbacks();
+	pools.erase(this);
+}
+
+bool JobPool::Shared::takeJob(unsigned int index, Job& job) {
+	{
+		JobQueue& own = *queues[index];
+		std::lock_guard<std::mutex> guard(own.mutex);
+		if (!own.jobs.empty()) {
+			job = std::move(own.jobs.front());
+			own.jobs.pop_front();
+			return true;
+		}
+	}
+
+	for (unsigned int i = 1; i < queues.size(); i++) {
+		JobQueue& victim = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> guard(victim.mutex);
+		if (!victim.jobs.empty()) {
+			job = std::move(victim.jobs.back());
+			victim.jobs.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobPool::Shared::waitForJob(unsigned int index, Job& job) {
+	while (!stopping) {
+		if (takeJob(index, job)) return;
+
+		numSleeping.fetch_add(1);
+		uint32_t seen = jobSequence.load();
+		// Anything submitted after this bumps the sequence and wakes us
+		if (takeJob(index, job)) {
+			numSleeping.fetch_sub(1);
+			return;
+		}
+		if (!stopping) futexWait(&jobSequence, seen, -1);
+		numSleeping.fetch_sub(1);
+	}
+}
+
+void JobPool::runThread(std::shared_ptr<Shared> shared, unsigned int index,
+                        std::string fileName) {
+	sol::state state;
+	defineThreadSafeAPIs(&state);
+
+	{
+		sol::load_result load = state.load_file(fileName);
+		if (noLuaCallError(&load)) {
+			sol::protected_function_result res = load();
+			noLuaCallError(&res);
+		}
+	}
+
+	while (true) {
+		Job job;
+		shared->waitForJob(index, job);
+		if (shared->stopping) break;
+
+		Completion completion;
+		completion.id = job.id;
+		completion.hasResult = false;
+		completion.isEncoded = false;
+
+		sol::protected_function func = state[job.functionName];
+		if (func == sol::nil) {
+			completion.error = "No job function named " + job.functionName;
+		} else {
+			auto res = func(job.payload);
+			if (!res.valid()) {
+				sol::error err = res;
+				completion.error = err.what();
+			} else if (res.return_count()) {
+				sol::object result = res;
+				if (result.is<std::string>()) {
+					completion.hasResult = true;
+					completion.result = result.as<std::string>();
+				} else if (result != sol::nil) {
+					try {
+						completion.result =
+						    Serialize::encode(result, getSerializeCodec());
+						completion.hasResult = true;
+						completion.isEncoded = true;
+					} catch (const std::exception& e) {
+						completion.error = e.what();
+					}
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> guard(shared->completionsMutex);
+		shared->completions.push_back(std::move(completion));
+	}
+}
+
+void JobPool::submit(std::string functionName, std::string payload,
+                     sol::protected_function callback) {
+	if (shared->stopping) throw std::runtime_error("Pool has been stopped");
+
+	uint64_t id = nextJobID++;
+	if (callback != sol::nil) {
+		sol::table registry = lua->registry();
+		sol::object existing = registry[callbackTableKey];
+		if (!existing.is<sol::table>())
+			registry[callbackTableKey] = lua->create_table();
+		registry[callbackTableKey][id] = callback;
+	}
+	pendingIDs.insert(id);
+
+	JobQueue& queue = *shared->queues[nextQueue++ % numThreads];
+	{
+		std::lock_guard<std::mutex> guard(queue.mutex);
+		queue.jobs.push_back({id, std::move(functionName), std::move(payload)});
+	}
+
+	shared->jobSequence.fetch_add(1);
+	if (shared->numSleeping.load()) futexWake(&shared->jobSequence, 1);
+}
+
+unsigned int JobPool::getNumPending() const { return pendingIDs.size(); }
+
+unsigned int JobPool::getNumThreads() const { return numThreads; }
+
+// Doesn't wait for the threads, which exit once they finish what they're on
+void JobPool::shutdown() {
+	if (shared->stopping.exchange(true)) return;
+
+	shared->jobSequence.fetch_add(1);
+	futexWakeAll(&shared->jobSequence);
+}
+
+void JobPool::releaseCallbacks() {
+	if (pendingIDs.empty()) return;
+
+	sol::object callbacks = lua->registry()[callbackTableKey];
+	if (callbacks.is<sol::table>()) {
+		sol::table table = callbacks;
+		for (uint64_t id : pendingIDs) table[id] = sol::lua_nil;
+	}
+	pendingIDs.clear();
+}
+
+void JobPool::stop() {
+	shutdown();
+	releaseCallbacks();
+}
+
+void JobPool::drain(sol::table& callbacks) {
+	std::deque<Completion> finished;
+	{
+		std::lock_guard<std::mutex> guard(shared->completionsMutex);
+		finished.swap(shared->completions);
+	}
+
+	for (auto& completion : finished) {
+		if (!pendingIDs.erase(completion.id)) continue;
+
+		sol::protected_function callback = callbacks[completion.id];
+		if (callback == sol::nil) {
+			// Nobody else is going to hear about it
+			if (!completion.error.empty()) {
+				sol::error err(completion.error);
+				printLuaError(&err);
+			}
+			continue;
+		}
+		callbacks[completion.id] = sol::lua_nil;
+
+		sol::object result = sol::make_object(*lua, sol::lua_nil);
+		if (completion.isEncoded) {
+			try {
+				result = Serialize::decode(lua->lua_state(), completion.result,
+				                           getSerializeCodec());
+			} catch (const std::exception& e) {
+				completion.error = e.what();
+			}
+		} else if (completion.hasResult) {
+			result = sol::make_object(*lua, std::move(completion.result));
+		}
+
+		sol::protected_function_result res;
+		if (!completion.error.empty())
+			res = callback(sol::lua_nil, completion.error);
+		else if (completion.hasResult)
+			res = callback(result);
+		else
+			res = callback();
+		noLuaCallError(&res);
+
+		// The callback may have let go of the last reference to this pool
+		if (!pools.count(this)) return;
+	}
+}
+
+void JobPool::drainCompletions() {
+	if (pools.empty()) return;
+
+	sol::table registry = lua->registry();
+	sol::object existing = registry[callbackTableKey];
+	sol::table callbacks =
+	    existing.is<sol::table>() ? existing.as<sol::table>() : lua->create_table();
+
+	// Callbacks may create or destroy pools
+	std::vector<JobPool*> current(pools.begin(), pools.end());
+	for (JobPool* pool : current)
+		if (pools.count(pool)) pool->drain(callbacks);
+}
+
+void JobPool::forgetCallbacks() {
+	// The whole callback table goes with the state
+	for (JobPool* pool : pools) pool->pendingIDs.clear();
+}
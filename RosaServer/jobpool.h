@@ -0,0 +1,83 @@
+#pragma once
+#include "sol/sol.hpp"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// A fixed set of threads, each with its own Lua state running the same file,
+// taking named jobs from per-thread deques and stealing from each other when
+// they run dry. Everything but the threads themselves is tick thread only.
+class JobPool {
+	static constexpr const char* callbackTableKey = "RosaServer.jobCallbacks";
+	static std::set<JobPool*> pools;
+	static uint64_t nextJobID;
+
+	struct Job {
+		uint64_t id;
+		std::string functionName;
+		std::string payload;
+	};
+
+	struct Completion {
+		uint64_t id;
+		bool hasResult;
+		// Anything but a string result goes through the serializer
+		bool isEncoded;
+		std::string result;
+		std::string error;
+	};
+
+	// Owners take from the front, thieves from the back
+	struct JobQueue {
+		std::deque<Job> jobs;
+		std::mutex mutex;
+	};
+
+	// Owned jointly with the threads, so a stopped pool doesn't have to wait for
+	// a long job before it can go away
+	struct Shared {
+		std::vector<std::unique_ptr<JobQueue>> queues;
+		std::atomic_uint32_t jobSequence{0};
+		std::atomic_uint32_t numSleeping{0};
+		std::atomic_bool stopping{false};
+
+		std::deque<Completion> completions;
+		std::mutex completionsMutex;
+
+		bool takeJob(unsigned int index, Job& job);
+		void waitForJob(unsigned int index, Job& job);
+	};
+
+	std::shared_ptr<Shared> shared;
+	unsigned int numThreads;
+	unsigned int nextQueue = 0;
+	std::set<uint64_t> pendingIDs;
+
+	static void runThread(std::shared_ptr<Shared> shared, unsigned int index,
+	                      std::string fileName);
+	void shutdown();
+	void releaseCallbacks();
+	void drain(sol::table& callbacks);
+
+ public:
+	JobPool(unsigned int numThreads, std::string fileName);
+	~JobPool();
+	void submit(std::string functionName, std::string payload,
+	            sol::protected_function callback);
+	unsigned int getNumPending() const;
+	unsigned int getNumThreads() const;
+	// Discards jobs not started yet. Running ones finish in the background, but
+	// their callbacks aren't called.
+	void stop();
+
+	// Calls back for finished jobs of every pool, on the tick thread
+	static void drainCompletions();
+	// Called before the state is closed, so pools it collects on the way out
+	// don't touch it
+	static void forgetCallbacks();
+};
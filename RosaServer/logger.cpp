@@ -0,0 +1,355 @@
+#include "logger.h"
+#include "console.h"
+#include "futex.h"
+
+#include <sys/stat.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace Logger {
+static constexpr size_t queueCapacity = 16384;
+// Lines written to the terminal with one redraw of the input line
+static constexpr size_t maxBatch = 256;
+static constexpr size_t cacheLineSize = 64;
+
+static const char* const levelNames[numLevels] = {"debug", "info", "warning",
+                                                  "error"};
+
+struct Entry {
+	Level level;
+	std::chrono::system_clock::time_point time;
+	std::string line;
+};
+
+// Dmitry Vyukov's bounded queue. Producers claim a cell by position and mark
+// it full through its sequence, so a slow producer only holds up its own cell.
+class EntryQueue {
+	struct Cell {
+		std::atomic_size_t sequence;
+		Entry entry;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+
+	alignas(cacheLineSize) std::atomic_size_t enqueuePosition{0};
+	// Only touched by the writer thread
+	alignas(cacheLineSize) size_t dequeuePosition = 0;
+
+ public:
+	EntryQueue() : cells(new Cell[queueCapacity]) {
+		for (size_t i = 0; i < queueCapacity; i++) cells[i].sequence.store(i);
+	}
+
+	bool push(Entry&& entry) {
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+
+		while (true) {
+			Cell& cell = cells[position & (queueCapacity - 1)];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			auto difference = static_cast<intptr_t>(sequence) -
+			                  static_cast<intptr_t>(position);
+
+			if (difference == 0) {
+				if (enqueuePosition.compare_exchange_weak(
+				        position, position + 1, std::memory_order_relaxed)) {
+					cell.entry = std::move(entry);
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool pop(Entry& entry) {
+		Cell& cell = cells[dequeuePosition & (queueCapacity - 1)];
+		size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		if (sequence != dequeuePosition + 1) return false;
+
+		entry = std::move(cell.entry);
+		cell.sequence.store(dequeuePosition + queueCapacity,
+		                    std::memory_order_release);
+		dequeuePosition++;
+		return true;
+	}
+
+	size_t size() const {
+		size_t enqueued = enqueuePosition.load(std::memory_order_relaxed);
+		size_t dequeued = numDequeued.load(std::memory_order_relaxed);
+		return enqueued > dequeued ? enqueued - dequeued : 0;
+	}
+
+	// Mirrors dequeuePosition for other threads
+	std::atomic_size_t numDequeued{0};
+};
+
+struct FileSink {
+	std::string path;
+	FileOptions options;
+	FILE* file = nullptr;
+	size_t size = 0;
+};
+
+static EntryQueue* queue;
+static std::once_flag startFlag;
+
+// Bumped to wake the writer thread when it's asleep
+static std::atomic_uint32_t wakeSequence{0};
+static std::atomic_bool writerSleeping{false};
+
+static std::atomic<Level> consoleLevel{levelDebug};
+// Anything below both the console and file levels is skipped before queueing
+static std::atomic<Level> minLevel{levelDebug};
+
+static std::atomic_uint64_t numLogged{0};
+static std::atomic_uint64_t numWritten{0};
+static std::atomic_uint64_t numDropped[numLevels];
+static std::atomic_uint64_t numRotations{0};
+
+// Held by the writer thread while writing, and by anyone changing the file
+static std::mutex fileMutex;
+static FileSink fileSink;
+
+static void updateMinLevel() {
+	Level level = consoleLevel;
+	if (fileSink.file && fileSink.options.level < level)
+		level = fileSink.options.level;
+	minLevel = level;
+}
+
+static uint64_t getTotalDropped() {
+	uint64_t total = 0;
+	for (auto& count : numDropped) total += count.load();
+	return total;
+}
+
+// Terminal colours are noise in a file
+static std::string stripEscapes(const std::string& line) {
+	std::string stripped;
+	stripped.reserve(line.size());
+
+	for (size_t i = 0; i < line.size(); i++) {
+		if (line[i] == '\033' && i + 1 < line.size() && line[i + 1] == '[') {
+			i += 2;
+			while (i < line.size() && (line[i] < '@' || line[i] > '~')) i++;
+			continue;
+		}
+		stripped += line[i];
+	}
+
+	return stripped;
+}
+
+static void formatTime(std::chrono::system_clock::time_point time,
+                       char (&buffer)[32]) {
+	time_t seconds = std::chrono::system_clock::to_time_t(time);
+	auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+	                        time.time_since_epoch())
+	                        .count() %
+	                    1000;
+
+	tm local;
+	localtime_r(&seconds, &local);
+	size_t length = strftime(buffer, sizeof(buffer), "%F %T", &local);
+	snprintf(buffer + length, sizeof(buffer) - length, ".%03d",
+	         static_cast<int>(milliseconds));
+}
+
+// Called with fileMutex held
+static void rotateFile() {
+	fclose(fileSink.file);
+	fileSink.file = nullptr;
+
+	const std::string& path = fileSink.path;
+	unsigned int maxFiles = fileSink.options.maxFiles;
+
+	if (maxFiles) {
+		for (unsigned int i = maxFiles - 1; i > 0; i--) {
+			std::string from = path + '.' + std::to_string(i);
+			std::string to = path + '.' + std::to_string(i + 1);
+			rename(from.c_str(), to.c_str());
+		}
+		rename(path.c_str(), (path + ".1").c_str());
+	}
+
+	// Without anywhere to keep old lines, they're simply discarded
+	fileSink.file = fopen(path.c_str(), maxFiles ? "a" : "w");
+	fileSink.size = 0;
+	numRotations++;
+}
+
+// Called with fileMutex held
+static void writeToFile(const Entry& entry) {
+	if (!fileSink.file || entry.level < fileSink.options.level) return;
+
+	char time[32];
+	formatTime(entry.time, time);
+
+	std::string text = stripEscapes(entry.line);
+	if (text.empty() || text.back() != '\n') text += '\n';
+
+	char prefix[64];
+	int prefixLength = snprintf(prefix, sizeof(prefix), "%s %-7s ", time,
+	                            levelNames[entry.level]);
+
+	size_t length = prefixLength + text.size();
+	if (fileSink.size && fileSink.size + length > fileSink.options.maxBytes) {
+		rotateFile();
+		if (!fileSink.file) return;
+	}
+
+	fwrite(prefix, 1, prefixLength, fileSink.file);
+	fwrite(text.data(), 1, text.size(), fileSink.file);
+	fileSink.size += length;
+}
+
+static void threadMain() {
+	uint64_t reportedDropped = 0;
+	Entry entry;
+	std::string consoleText;
+
+	while (true) {
+		consoleText.clear();
+		size_t count = 0;
+
+		{
+			std::lock_guard<std::mutex> guard(fileMutex);
+
+			while (count < maxBatch && queue->pop(entry)) {
+				if (entry.level >= consoleLevel) consoleText += entry.line;
+				writeToFile(entry);
+				count++;
+			}
+
+			uint64_t dropped = getTotalDropped();
+			if (dropped != reportedDropped) {
+				Entry notice{levelWarning, std::chrono::system_clock::now(),
+				             std::to_string(dropped - reportedDropped) +
+				                 " log lines dropped, the queue was full\n"};
+				consoleText += "\033[33m" + notice.line + "\033[0m";
+				writeToFile(notice);
+				reportedDropped = dropped;
+			}
+
+			if (fileSink.file && count) fflush(fileSink.file);
+		}
+
+		if (!consoleText.empty()) Console::write(consoleText);
+
+		if (count) {
+			queue->numDequeued.fetch_add(count, std::memory_order_relaxed);
+			numWritten.fetch_add(count);
+			continue;
+		}
+
+		uint32_t sequence = wakeSequence.load();
+		writerSleeping = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!queue->size()) futexWait(&wakeSequence, sequence, -1);
+		writerSleeping = false;
+	}
+}
+
+static void start() {
+	queue = new EntryQueue();
+	std::thread thread(threadMain);
+	thread.detach();
+}
+
+bool log(Level level, std::string line) {
+	if (level < minLevel.load(std::memory_order_relaxed)) return true;
+
+	std::call_once(startFlag, start);
+
+	Entry entry{level, std::chrono::system_clock::now(), std::move(line)};
+	if (!queue->push(std::move(entry))) {
+		numDropped[level].fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	numLogged.fetch_add(1);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (writerSleeping.load(std::memory_order_relaxed)) {
+		wakeSequence.fetch_add(1);
+		futexWake(&wakeSequence, 1);
+	}
+	return true;
+}
+
+Level getConsoleLevel() { return consoleLevel; }
+
+void setConsoleLevel(Level level) {
+	std::lock_guard<std::mutex> guard(fileMutex);
+	consoleLevel = level;
+	updateMinLevel();
+}
+
+void openFile(const std::string& path, const FileOptions& options) {
+	FILE* file = fopen(path.c_str(), "a");
+	if (!file) throw std::runtime_error(strerror(errno));
+
+	struct stat info;
+	size_t size = fstat(fileno(file), &info) == 0 ? info.st_size : 0;
+
+	std::lock_guard<std::mutex> guard(fileMutex);
+	if (fileSink.file) fclose(fileSink.file);
+	fileSink = {path, options, file, size};
+	updateMinLevel();
+}
+
+void closeFile() {
+	std::lock_guard<std::mutex> guard(fileMutex);
+	if (fileSink.file) fclose(fileSink.file);
+	fileSink = FileSink();
+	updateMinLevel();
+}
+
+bool flush(int timeoutMs) {
+	uint64_t target = numLogged.load();
+	auto deadline =
+	    std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+	// Only used when shutting down or testing, so polling is fine
+	while (numWritten.load() < target) {
+		if (std::chrono::steady_clock::now() >= deadline) return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+Stats getStats() {
+	std::call_once(startFlag, start);
+
+	Stats stats;
+	stats.queued = queue->size();
+	stats.capacity = queueCapacity;
+	stats.logged = numLogged;
+	stats.written = numWritten;
+	stats.dropped = 0;
+	for (int i = 0; i < numLevels; i++) {
+		stats.droppedByLevel[i] = numDropped[i];
+		stats.dropped += stats.droppedByLevel[i];
+	}
+	stats.rotations = numRotations;
+	return stats;
+}
+
+const char* getLevelName(Level level) { return levelNames[level]; }
+
+Level parseLevel(const std::string& name) {
+	for (int i = 0; i < numLevels; i++) {
+		if (name == levelNames[i]) return static_cast<Level>(i);
+	}
+	throw std::invalid_argument("Unknown log level");
+}
+}  // namespace Logger
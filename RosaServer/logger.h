@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Lines logged from any thread go into a lock-free queue and are written out
+// by a background thread, so logging never waits on the terminal or the disk.
+namespace Logger {
+enum Level : uint8_t { levelDebug, levelInfo, levelWarning, levelError };
+static constexpr int numLevels = 4;
+
+struct FileOptions {
+	// Rotated once it would grow past this
+	size_t maxBytes = 16 * 1024 * 1024;
+	// Old files kept as path.1 (newest) to path.N
+	unsigned int maxFiles = 5;
+	Level level = levelDebug;
+};
+
+struct Stats {
+	unsigned int queued;
+	unsigned int capacity;
+	uint64_t logged;
+	uint64_t written;
+	uint64_t dropped;
+	uint64_t droppedByLevel[numLevels];
+	uint64_t rotations;
+};
+
+// Never blocks. Returns false if the queue was full and the line was dropped.
+bool log(Level level, std::string line);
+
+Level getConsoleLevel();
+void setConsoleLevel(Level level);
+// Appends to the file, throws if it can't be opened
+void openFile(const std::string& path, const FileOptions& options);
+void closeFile();
+
+// Waits for everything logged so far to be written. Returns false on timeout.
+bool flush(int timeoutMs);
+Stats getStats();
+
+const char* getLevelName(Level level);
+// Throws on unknown names
+Level parseLevel(const std::string& name);
+}  // namespace Logger
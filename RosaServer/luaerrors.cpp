@@ -0,0 +1,241 @@
+#include "luaerrors.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+namespace LuaErrors {
+using Clock = std::chrono::steady_clock;
+
+// Beyond this, the least recently seen fingerprint is forgotten
+static constexpr size_t maxFingerprints = 4096;
+
+struct FingerprintState {
+	std::string message;
+	uint64_t count = 0;
+	uint64_t suppressed = 0;
+	// Held back since the error was last shown
+	uint64_t pending = 0;
+	double tokens;
+	Clock::time_point lastRefill;
+	Clock::time_point lastSeen;
+};
+
+struct EventState {
+	Clock::time_point windowStart;
+	unsigned int count = 0;
+	bool disabled = false;
+};
+
+static std::mutex stateMutex;
+static Options options;
+static std::unordered_map<uint64_t, FingerprintState> fingerprints;
+static std::unordered_map<std::string, EventState> events;
+static size_t numPending = 0;
+
+static uint64_t numErrors = 0;
+static uint64_t numPrinted = 0;
+static uint64_t numSuppressed = 0;
+
+// Lets isEnabled skip the lock in the usual case of nothing being disabled
+static std::atomic_uint32_t numDisabled{0};
+
+// The same error about a different index, address or line count is the same
+// bug, so runs of digits don't count
+static uint64_t getFingerprint(const std::string& error) {
+	std::string normalized;
+	normalized.reserve(error.size());
+
+	for (size_t i = 0; i < error.size(); i++) {
+		if (std::isdigit(static_cast<unsigned char>(error[i]))) {
+			normalized += '#';
+			while (i + 1 < error.size() &&
+			       std::isdigit(static_cast<unsigned char>(error[i + 1])))
+				i++;
+			continue;
+		}
+		normalized += error[i];
+	}
+
+	return std::hash<std::string>()(normalized);
+}
+
+static std::string getFirstLine(const std::string& error) {
+	return error.substr(0, error.find('\n'));
+}
+
+// Called with the lock held
+static bool takeToken(FingerprintState& state, Clock::time_point now) {
+	double seconds =
+	    std::chrono::duration<double>(now - state.lastRefill).count();
+	state.tokens = std::min<double>(options.burst,
+	                                state.tokens + seconds * options.perSecond);
+	state.lastRefill = now;
+
+	if (state.tokens < 1) return false;
+	state.tokens--;
+	return true;
+}
+
+// Called with the lock held
+static FingerprintState& getState(uint64_t fingerprint,
+                                  const std::string& error,
+                                  Clock::time_point now) {
+	auto it = fingerprints.find(fingerprint);
+	if (it != fingerprints.end()) return it->second;
+
+	if (fingerprints.size() >= maxFingerprints) {
+		auto oldest = std::min_element(
+		    fingerprints.begin(), fingerprints.end(), [](auto& a, auto& b) {
+			    return a.second.lastSeen < b.second.lastSeen;
+		    });
+		if (oldest->second.pending) numPending--;
+		fingerprints.erase(oldest);
+	}
+
+	FingerprintState state;
+	state.message = getFirstLine(error);
+	state.tokens = options.burst;
+	state.lastRefill = now;
+	return fingerprints.emplace(fingerprint, std::move(state)).first->second;
+}
+
+// Called with the lock held
+static void countAgainstEvent(const char* event, Clock::time_point now) {
+	if (!options.disableThreshold) return;
+
+	EventState& state = events[event];
+	if (state.disabled) return;
+
+	auto window = std::chrono::duration<double>(options.disableWindowSeconds);
+	if (!state.count || now - state.windowStart > window) {
+		state.windowStart = now;
+		state.count = 0;
+	}
+
+	if (++state.count < options.disableThreshold) return;
+
+	state.disabled = true;
+	numDisabled++;
+
+	Logger::log(Logger::levelWarning,
+	            "\033[33mDisabled the " + std::string(event) + " event after " +
+	                std::to_string(state.count) +
+	                " errors, luaErrors.enableEvent turns it back on\033[0m\n");
+}
+
+void report(const std::string& error, const char* event) {
+	auto now = Clock::now();
+	uint64_t pending = 0;
+
+	{
+		std::lock_guard<std::mutex> guard(stateMutex);
+		numErrors++;
+		if (event) countAgainstEvent(event, now);
+
+		FingerprintState& state = getState(getFingerprint(error), error, now);
+		state.count++;
+		state.lastSeen = now;
+
+		if (!takeToken(state, now)) {
+			if (!state.pending) numPending++;
+			state.pending++;
+			state.suppressed++;
+			numSuppressed++;
+			return;
+		}
+
+		if (state.pending) numPending--;
+		pending = state.pending;
+		state.pending = 0;
+		numPrinted++;
+	}
+
+	std::string line = "\033[41;1m Lua error \033[0m\n\033[31m" + error;
+	if (pending)
+		line += "\n(repeated " + std::to_string(pending) + " times since shown)";
+	line += "\033[0m\n";
+	Logger::log(Logger::levelError, std::move(line));
+}
+
+void flushSummaries() {
+	std::lock_guard<std::mutex> guard(stateMutex);
+	if (!numPending) return;
+
+	auto now = Clock::now();
+	for (auto& [fingerprint, state] : fingerprints) {
+		if (!state.pending || !takeToken(state, now)) continue;
+
+		Logger::log(Logger::levelError,
+		            "\033[31mLua error repeated " + std::to_string(state.pending) +
+		                " times: " + state.message + "\033[0m\n");
+		state.pending = 0;
+		numPending--;
+	}
+}
+
+bool isEnabled(const char* event) {
+	if (!numDisabled.load(std::memory_order_relaxed)) return true;
+
+	std::lock_guard<std::mutex> guard(stateMutex);
+	auto it = events.find(event);
+	return it == events.end() || !it->second.disabled;
+}
+
+void enableEvent(const std::string& event) {
+	std::lock_guard<std::mutex> guard(stateMutex);
+	auto it = events.find(event);
+	if (it == events.end() || !it->second.disabled) return;
+
+	it->second = EventState();
+	numDisabled--;
+}
+
+void enableAllEvents() {
+	std::lock_guard<std::mutex> guard(stateMutex);
+	events.clear();
+	numDisabled = 0;
+}
+
+Options getOptions() {
+	std::lock_guard<std::mutex> guard(stateMutex);
+	return options;
+}
+
+void setOptions(const Options& newOptions) {
+	std::lock_guard<std::mutex> guard(stateMutex);
+	options = newOptions;
+}
+
+Stats getStats() {
+	std::lock_guard<std::mutex> guard(stateMutex);
+
+	Stats stats;
+	stats.errors = numErrors;
+	stats.printed = numPrinted;
+	stats.suppressed = numSuppressed;
+	stats.numFingerprints = fingerprints.size();
+	for (auto& [event, state] : events) {
+		if (state.disabled) stats.disabledEvents.push_back(event);
+	}
+	return stats;
+}
+
+std::vector<Fingerprint> getFingerprints() {
+	std::lock_guard<std::mutex> guard(stateMutex);
+
+	std::vector<Fingerprint> list;
+	list.reserve(fingerprints.size());
+	for (auto& [fingerprint, state] : fingerprints)
+		list.push_back({state.message, state.count, state.suppressed});
+
+	// Worst first
+	std::sort(list.begin(), list.end(),
+	          [](auto& a, auto& b) { return a.count > b.count; });
+	return list;
+}
+}  // namespace LuaErrors
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Keeps a broken handler from flooding the console. Identical errors are
+// grouped by fingerprint and rate limited, and events that keep erroring can
+// be switched off. Safe to use from any thread.
+namespace LuaErrors {
+struct Options {
+	// Each fingerprint's token bucket
+	unsigned int burst = 3;
+	double perSecond = 0.2;
+	// Errors within the window that disable an event, 0 never does. Hooks are
+	// dispatched once per event, so this switches off every handler of the
+	// event, not only the one that keeps failing.
+	unsigned int disableThreshold = 0;
+	double disableWindowSeconds = 10;
+};
+
+struct Fingerprint {
+	// First line of the first error seen
+	std::string message;
+	uint64_t count;
+	uint64_t suppressed;
+};
+
+struct Stats {
+	uint64_t errors;
+	uint64_t printed;
+	uint64_t suppressed;
+	size_t numFingerprints;
+	std::vector<std::string> disabledEvents;
+};
+
+// Logs the error unless its fingerprint is over its rate. Errors from a hook
+// count against its event.
+void report(const std::string& error, const char* event);
+// Summarizes errors that were held back, once their fingerprints are under
+// their rate again. Called every tick.
+void flushSummaries();
+
+bool isEnabled(const char* event);
+void enableEvent(const std::string& event);
+// When the state is reset, handlers get another chance
+void enableAllEvents();
+
+Options getOptions();
+void setOptions(const Options& options);
+Stats getStats();
+std::vector<Fingerprint> getFingerprints();
+}  // namespace LuaErrors
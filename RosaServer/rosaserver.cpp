@@ -1,6 +1,7 @@
 ﻿#include "rosaserver.h"
 #include <cxxabi.h>
 #include <execinfo.h>
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <cerrno>
 #include <filesystem>
@@ -21,7 +22,6 @@ static unsigned int* numBuildings;
 static int* maxPlayers;
 static char* adminPassword;
 static int* doVoiceChat;
-static float* gravity;
 static float originalGravity;
 
 static void pryMemory(void* address, size_t numPages) {
@@ -69,8 +69,8 @@ struct Server {
 	//char* getLoadedLevelName() const { return Engine::loadedMapName; }
 	bool getDoVoiceChat() const { return *doVoiceChat; }
 	void setDoVoiceChat(bool b) const { *doVoiceChat = b; }
-	//float getGravity() const { return *gravity; }
-	//void setGravity(float g) const { *gravity = g; }
+	//float getGravity() const { return *Engine::gravity; }
+	//void setGravity(float g) const { *Engine::gravity = g; }
 	float getDefaultGravity() const { return originalGravity; }
 	int getState() const { return *Engine::gameState; }
 	void setState(int state) const { *Engine::gameState = state; }
@@ -117,17 +117,15 @@ static int wrapCExceptions(lua_State* L, lua_CFunction f) {
 }
 
 static int wrapExceptions(lua_State* L, sol::optional<const std::exception&> maybe_exception, sol::string_view description) {
-	Console::log(LUA_PREFIX "Exception caught. Outputting description.\n");
+	Logger::log(Logger::levelError,
+	            LUA_PREFIX "Exception caught. Outputting description.\n");
 	if (maybe_exception) {
-		Console::log("(straight from the exception):\n");
 		const std::exception& ex = *maybe_exception;
-		Console::log(ex.what());
-		std::cout << "\n";
+		Logger::log(Logger::levelError, "(straight from the exception):\n" +
+		                                    std::string(ex.what()) + "\n");
 	} else {
-		Console::log("(from the description parameter):\n");
-		std::cout.write(description.data(),
-		                static_cast<std::streamsize>(description.size()));
-		std::cout << "\n";
+		Logger::log(Logger::levelError, "(from the description parameter):\n" +
+		                                    std::string(description) + "\n");
 	}
 
 	return sol::stack::push(L, description);
@@ -172,6 +170,10 @@ void defineThreadSafeAPIs(sol::state* state) {
 		meta["mult"] = &Vector::mult;
 		meta["set"] = &Vector::set;
 		meta["cross"] = &Vector::cross;
+		meta["addScaled"] = &Vector::addScaled;
+		meta["lerpTo"] = &Vector::lerpTo;
+		meta["rotateBy"] = &Vector::rotateBy;
+		meta["transformInto"] = &Vector::transformInto;
 		meta["clone"] = &Vector::clone;
 		meta["dist"] = &Vector::dist;
 		meta["distSquare"] = &Vector::distSquare;
@@ -199,6 +201,10 @@ void defineThreadSafeAPIs(sol::state* state) {
 		meta["__tostring"] = &RotMatrix::__tostring;
 		meta["__mul"] = &RotMatrix::__mul;
 		meta["set"] = &RotMatrix::set;
+		meta["rotateBy"] = &RotMatrix::rotateBy;
+		meta["orthonormalize"] = &RotMatrix::orthonormalize;
+		meta["fromEuler"] = &RotMatrix::fromEuler;
+		meta["slerp"] = &RotMatrix::slerp;
 		meta["clone"] = &RotMatrix::clone;
 		meta["getForward"] = &RotMatrix::getForward;
 		meta["getUp"] = &RotMatrix::getUp;
@@ -221,8 +227,40 @@ void defineThreadSafeAPIs(sol::state* state) {
 
 	(*state)["print"] = Lua::print;
 
+	{
+		auto loggerTable = state->create_table();
+		(*state)["logger"] = loggerTable;
+		loggerTable["debug"] = Lua::logger::debug;
+		loggerTable["info"] = Lua::logger::info;
+		loggerTable["warning"] = Lua::logger::warning;
+		loggerTable["error"] = Lua::logger::error;
+		loggerTable["getConsoleLevel"] = Lua::logger::getConsoleLevel;
+		loggerTable["setConsoleLevel"] = Lua::logger::setConsoleLevel;
+		loggerTable["openFile"] = Lua::logger::openFile;
+		loggerTable["closeFile"] = Lua::logger::closeFile;
+		loggerTable["flush"] = Lua::logger::flush;
+		loggerTable["getStats"] = Lua::logger::getStats;
+	}
+
+	{
+		auto luaErrorsTable = state->create_table();
+		(*state)["luaErrors"] = luaErrorsTable;
+		luaErrorsTable["configure"] = Lua::luaErrors::configure;
+		luaErrorsTable["getStats"] = Lua::luaErrors::getStats;
+		luaErrorsTable["getFingerprints"] = Lua::luaErrors::getFingerprints;
+		luaErrorsTable["enableEvent"] = Lua::luaErrors::enableEvent;
+	}
+
+	{
+		auto flightRecorderTable = state->create_table();
+		(*state)["flightRecorder"] = flightRecorderTable;
+		flightRecorderTable["dump"] = Lua::flightRecorder::dump;
+		flightRecorderTable["getRecent"] = Lua::flightRecorder::getRecent;
+	}
+
 	(*state)["Vector"] = sol::overload(Lua::Vector_, Lua::Vector_3f);
 	(*state)["RotMatrix"] = Lua::RotMatrix_;
+	defineFFIMath(state);
 
 	(*state)["os"]["listDirectory"] = Lua::os::listDirectory;
 	(*state)["os"]["createDirectory"] = Lua::os::createDirectory;
@@ -234,6 +272,51 @@ void defineThreadSafeAPIs(sol::state* state) {
 		(*state)["http"] = httpTable;
 		httpTable["getSync"] = Lua::http::getSync;
 		httpTable["postSync"] = Lua::http::postSync;
+		httpTable["setPoolLimits"] = Lua::http::setPoolLimits;
+		httpTable["getPoolStats"] = Lua::http::getPoolStats;
+	}
+
+	{
+		auto serializeTable = state->create_table();
+		(*state)["serialize"] = serializeTable;
+		serializeTable["encode"] = Lua::serialize::encode;
+		serializeTable["decode"] = Lua::serialize::decode;
+	}
+
+	{
+		auto meta = state->new_usertype<SharedTable>("SharedTable",
+		                                             sol::no_constructor);
+		// SharedTable.get(name) and table:get(key)
+		meta["get"] = sol::overload(&SharedTable::get, &SharedTable::getValue);
+		meta["set"] = &SharedTable::set;
+		meta["delete"] = &SharedTable::remove;
+		meta["increment"] = &SharedTable::increment;
+		meta["compareAndSet"] = &SharedTable::compareAndSet;
+		meta["getSize"] = &SharedTable::getSize;
+	}
+
+	{
+		auto meta = state->new_usertype<WorldSnapshot::Handle>("WorldSnapshot",
+		                                                       sol::no_constructor);
+		meta["tick"] = sol::property(&WorldSnapshot::Handle::getTick);
+		meta["gameState"] = sol::property(&WorldSnapshot::Handle::getGameState);
+		meta["getPlayers"] = &WorldSnapshot::Handle::getPlayers;
+		meta["getHumans"] = &WorldSnapshot::Handle::getHumans;
+		meta["getItems"] = &WorldSnapshot::Handle::getItems;
+		meta["getVehicles"] = &WorldSnapshot::Handle::getVehicles;
+		meta["release"] = &WorldSnapshot::Handle::release;
+
+		auto worldTable = state->create_table();
+		(*state)["world"] = worldTable;
+		worldTable["getSnapshot"] = WorldSnapshot::acquire;
+	}
+
+	{
+		auto webhookTable = state->create_table();
+		(*state)["webhook"] = webhookTable;
+		webhookTable["enqueue"] = Lua::webhook::enqueue;
+		webhookTable["configure"] = Lua::webhook::configure;
+		webhookTable["getStats"] = Lua::webhook::getStats;
 	}
 }
 
@@ -242,6 +325,8 @@ void luaInit(bool redo) {
 
 	if (redo) {
 		Console::log(LUA_PREFIX "Resetting state...\n");
+		// The new state's handlers get a fresh start
+		LuaErrors::enableAllEvents();
 		delete server;
 
 		for (int i = 0; i < maxNumberOfPlayers; i++) {
@@ -279,6 +364,7 @@ void luaInit(bool redo) {
 			}
 		}
 
+		JobPool::forgetCallbacks();
 		delete lua;
 	} else {
 		Console::log(LUA_PREFIX "Initializing state...\n");
@@ -763,25 +849,59 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<Worker>(
-		    "Worker", sol::constructors<ChildProcess(std::string)>());
+		    "Worker", sol::constructors<Worker(std::string),
+		                                Worker(std::string, sol::table)>());
 		meta["stop"] = &Worker::stop;
 		meta["sendMessage"] = &Worker::sendMessage;
 		meta["receiveMessage"] = &Worker::receiveMessage;
+		meta["sendValue"] = &Worker::sendValue;
+		meta["receiveValue"] = &Worker::receiveValue;
+		meta["getStats"] = &Worker::getStats;
+	}
+
+	{
+		auto meta = lua->new_usertype<JobPool>("JobPool", sol::no_constructor);
+		meta["submit"] = &JobPool::submit;
+		meta["getNumPending"] = &JobPool::getNumPending;
+		meta["getNumThreads"] = &JobPool::getNumThreads;
+		meta["stop"] = &JobPool::stop;
+
+		auto jobsTable = lua->create_table();
+		(*lua)["jobs"] = jobsTable;
+		jobsTable["pool"] = Lua::jobs::pool;
 	}
 
 	{
 		auto meta = lua->new_usertype<ChildProcess>(
-		    "ChildProcess", sol::constructors<ChildProcess(std::string)>());
+		    "ChildProcess",
+		    sol::constructors<ChildProcess(std::string),
+		                      ChildProcess(std::string, sol::table)>());
 		meta["isRunning"] = &ChildProcess::isRunning;
 		meta["terminate"] = &ChildProcess::terminate;
 		meta["getExitCode"] = &ChildProcess::getExitCode;
 		meta["receiveMessage"] = &ChildProcess::receiveMessage;
+		meta["receiveMessages"] = &ChildProcess::receiveMessages;
 		meta["sendMessage"] = &ChildProcess::sendMessage;
+		meta["receiveValue"] = &ChildProcess::receiveValue;
+		meta["sendValue"] = &ChildProcess::sendValue;
 		meta["setCPULimit"] = &ChildProcess::setCPULimit;
 		meta["setMemoryLimit"] = &ChildProcess::setMemoryLimit;
 		meta["setFileSizeLimit"] = &ChildProcess::setFileSizeLimit;
 		meta["getPriority"] = &ChildProcess::getPriority;
 		meta["setPriority"] = &ChildProcess::setPriority;
+		meta["getJobStatus"] = &ChildProcess::getJobStatus;
+	}
+
+	{
+		auto meta = lua->new_usertype<SatellitePool>(
+		    "SatellitePool", sol::constructors<SatellitePool(unsigned int)>());
+		meta["acquireFile"] = &SatellitePool::acquireFile;
+		meta["acquireChunk"] = &SatellitePool::acquireChunk;
+		meta["release"] = &SatellitePool::release;
+		meta["setCPULimit"] = &SatellitePool::setCPULimit;
+		meta["setMemoryLimit"] = &SatellitePool::setMemoryLimit;
+		meta["setFileSizeLimit"] = &SatellitePool::setFileSizeLimit;
+		meta["getStats"] = &SatellitePool::getStats;
 	}
 
 	{
@@ -834,6 +954,28 @@ void luaInit(bool redo) {
 
 	(*lua)["flagStateForReset"] = Lua::flagStateForReset;
 
+	{
+		sol::table httpTable = (*lua)["http"];
+		httpTable["get"] = Lua::http::get;
+		httpTable["post"] = Lua::http::post;
+		httpTable["download"] = Lua::http::download;
+		httpTable["upload"] = Lua::http::upload;
+		httpTable["setCallbackBudget"] = Lua::http::setCallbackBudget;
+		httpTable["setMaxInFlight"] = Lua::http::setMaxInFlight;
+		httpTable["getNumInFlight"] = Lua::http::getNumInFlight;
+	}
+
+	{
+		auto serverTable = lua->create_table();
+		(*lua)["httpServer"] = serverTable;
+		serverTable["start"] = HTTPServer::start;
+		serverTable["stop"] = HTTPServer::stop;
+		serverTable["isRunning"] = HTTPServer::isRunning;
+		serverTable["addRoute"] = HTTPServer::addRoute;
+		serverTable["removeRoute"] = HTTPServer::removeRoute;
+		serverTable["setHandlerTimeout"] = HTTPServer::setHandlerTimeout;
+	}
+
 	(*lua)["hook"] = lua->create_table();
 	(*lua)["hook"]["persistentMode"] = hookMode;
 
@@ -851,9 +993,15 @@ void luaInit(bool redo) {
 		(*lua)["physics"] = physicsTable;
 		physicsTable["lineIntersectLevel"] = Lua::physics::lineIntersectLevel;
 		physicsTable["lineIntersectHuman"] = Lua::physics::lineIntersectHuman;
+		physicsTable["lineIntersectHumanAt"] = Lua::physics::lineIntersectHumanAt;
 		physicsTable["lineIntersectVehicle"] = Lua::physics::lineIntersectVehicle;
 		physicsTable["lineIntersectTriangle"] = Lua::physics::lineIntersectTriangle;
 		physicsTable["garbageCollectBullets"] = Lua::physics::garbageCollectBullets;
+		physicsTable["predictTrajectory"] = Lua::physics::predictTrajectory;
+		physicsTable["batchTranslate"] = Lua::physics::batchTranslate;
+		physicsTable["batchRotate"] = Lua::physics::batchRotate;
+		physicsTable["batchAddVelocity"] = Lua::physics::batchAddVelocity;
+		physicsTable["batchScaleVelocity"] = Lua::physics::batchScaleVelocity;
 	}
 
 	{
@@ -1150,9 +1298,9 @@ static inline void locateMemory(uintptr_t base) {
 	Engine::gameTicksSinceReset = (int*)(base + 0x24B62458);
 	Engine::sunTime = (unsigned int*)(base + 0xbe385c0);
 	doVoiceChat = (int*)(base + 0xda1840c);
-	gravity = (float*)(base + 0xa5cac);
-	//pryMemory(gravity, 1);
-	originalGravity = *gravity;
+	Engine::gravity = (float*)(base + 0xa5cac);
+	//pryMemory(Engine::gravity, 1);
+	originalGravity = *Engine::gravity;
 
 	Engine::lineIntersectResult = (RayCastResult*)(base + 0x26104460);
 
@@ -1362,36 +1510,18 @@ static inline void attachSignalHandler() {
 static void crashSignalHandler(int signal) {
 	Console::shouldExit = true;
 
-	std::stringstream sstream;
-	std::cerr << std::flush;
-	sstream << "\033[41;1m " << strsignal(signal) << " \033[0m\n\033[31m";
-
-	sstream << "Stack traceback:\n";
+	// Only async-signal-safe calls from here on, the heap or Lua state could be
+	// what's broken
+	void* frames[64];
+	int numFrames = backtrace(frames, 64);
 
-	void* backtraceEntries[10];
+	FlightRecorder::writeCrashReport(STDERR_FILENO, signal, frames, numFrames);
 
-	size_t backtraceSize = backtrace(backtraceEntries, 10);
-	auto backtraceSymbols = backtrace_symbols(backtraceEntries, backtraceSize);
-
-	for (int i = 0; i < backtraceSize; i++) {
-		sstream << "\t#" << i << ' ' << backtraceSymbols[i] << '\n';
-	}
-
-	sstream << std::flush;
-
-	luaL_traceback(*lua, *lua, nullptr, 0);
-	sstream << "Lua " << lua_tostring(*lua, -1);
-
-	sstream << "\033[0m" << std::endl;
-
-	std::cerr << sstream.str();
-
-	std::filesystem::remove(std::filesystem::path("rs_crash_report.txt"));
-	std::ofstream file("rs_crash_report.txt");
-	if (file.is_open()) {
-		file << sstream.str();
-		file.flush();
-		file.close();
+	int fd = open("rs_crash_report.txt", O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+	              0644);
+	if (fd != -1) {
+		FlightRecorder::writeCrashReport(fd, signal, frames, numFrames);
+		close(fd);
 	}
 
 	raise(signal);
@@ -1405,10 +1535,24 @@ static const std::array handledSignals = {
 };
 
 static inline void attachCrashSignalHandler() {
+	// Lets a stack overflow still be reported
+	static char alternateStack[64 * 1024];
+	stack_t stack{};
+	stack.ss_sp = alternateStack;
+	stack.ss_size = sizeof(alternateStack);
+	if (sigaltstack(&stack, nullptr) == -1) {
+		throw std::runtime_error(strerror(errno));
+	}
+
+	// The first call loads libgcc, which can't happen inside the handler
+	void* frame;
+	backtrace(&frame, 1);
+
 	struct sigaction signalAction;
 
 	signalAction.sa_handler = crashSignalHandler;
-	signalAction.sa_flags = SA_RESTART | SA_SIGINFO;
+	sigemptyset(&signalAction.sa_mask);
+	signalAction.sa_flags = SA_RESTART | SA_ONSTACK;
 
 	for (const auto signal : handledSignals) {
 		if (sigaction(signal, &signalAction, nullptr) == -1) {
@@ -11,6 +11,14 @@
 #include "childprocess.h"
 #include "console.h"
 #include "engine.h"
+#include "ffimath.h"
+#include "flightrecorder.h"
 #include "hooks.h"
+#include "httpserver.h"
 #include "image.h"
-#include "worker.h"
\ No newline at end of file
+#include "logger.h"
+#include "luaerrors.h"
+#include "satellitepool.h"
+#include "sharedtable.h"
+#include "worker.h"
+#include "worldsnapshot.h"
\ No newline at end of file
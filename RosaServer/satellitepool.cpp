@@ -0,0 +1,108 @@
+#include "satellitepool.h"
+
+#include <algorithm>
+#include <cmath>
+
+SatellitePool::SatellitePool(unsigned int size) : size(size) {
+	idle.reserve(size);
+	for (unsigned int i = 0; i < size; i++) idle.push_back(spawn());
+}
+
+std::shared_ptr<ChildProcess> SatellitePool::spawn() {
+	numSpawned++;
+	return std::shared_ptr<ChildProcess>(
+	    new ChildProcess(ChildProcess::Pooled{}));
+}
+
+bool SatellitePool::applyLimits(ChildProcess* child) {
+	// RLIMIT_CPU counts the process's whole life, not just this job
+	rlim_t cpu = cpuLimit;
+	if (cpu != RLIM_INFINITY)
+		cpu += static_cast<rlim_t>(std::ceil(child->getCPUSeconds()));
+
+	return child->setSoftLimit(RLIMIT_CPU, cpu) &&
+	       child->setSoftLimit(RLIMIT_AS, memoryLimit) &&
+	       child->setSoftLimit(RLIMIT_FSIZE, fileSizeLimit);
+}
+
+std::shared_ptr<ChildProcess> SatellitePool::acquire(
+    Framing::Control control, const std::string& source) {
+	std::shared_ptr<ChildProcess> child;
+
+	while (!idle.empty()) {
+		auto candidate = std::move(idle.back());
+		idle.pop_back();
+
+		if (candidate->isRunning() && applyLimits(candidate.get())) {
+			child = std::move(candidate);
+			numHits++;
+			break;
+		}
+
+		// Died while idle, or a script lowered a hard limit
+		candidate->terminate();
+		numReplaced++;
+	}
+
+	if (!child) {
+		numMisses++;
+		child = spawn();
+		if (!applyLimits(child.get()))
+			throw std::runtime_error("Couldn't apply resource limits");
+	}
+
+	child->startJob(control, source);
+	busy.push_back(child);
+	numJobs++;
+	return child;
+}
+
+std::shared_ptr<ChildProcess> SatellitePool::acquireFile(std::string fileName) {
+	return acquire(Framing::controlRunFile, fileName);
+}
+
+std::shared_ptr<ChildProcess> SatellitePool::acquireChunk(std::string source) {
+	return acquire(Framing::controlRunChunk, source);
+}
+
+void SatellitePool::release(std::shared_ptr<ChildProcess> child) {
+	auto it = std::find(busy.begin(), busy.end(), child);
+	if (it == busy.end())
+		throw std::invalid_argument("Satellite isn't acquired from this pool");
+	busy.erase(it);
+
+	// Also picks up the job finishing, if it has
+	child->discardMessages();
+
+	bool reusable = !child->jobRunning && child->isRunning();
+	if (reusable && idle.size() + busy.size() < size) {
+		idle.push_back(std::move(child));
+		return;
+	}
+
+	child->terminate();
+	if (!reusable) numReplaced++;
+	if (idle.size() + busy.size() < size) idle.push_back(spawn());
+}
+
+void SatellitePool::setCPULimit(rlim_t seconds) { cpuLimit = seconds; }
+
+void SatellitePool::setMemoryLimit(rlim_t bytes) { memoryLimit = bytes; }
+
+void SatellitePool::setFileSizeLimit(rlim_t bytes) { fileSizeLimit = bytes; }
+
+sol::table SatellitePool::getStats(sol::this_state s) const {
+	sol::state_view lua(s);
+
+	sol::table stats = lua.create_table(0, 8);
+	stats["size"] = size;
+	stats["idle"] = idle.size();
+	stats["busy"] = busy.size();
+	stats["jobs"] = numJobs;
+	stats["spawned"] = numSpawned;
+	// Jobs that didn't have to wait for a spawn
+	stats["hits"] = numHits;
+	stats["misses"] = numMisses;
+	stats["replaced"] = numReplaced;
+	return stats;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "childprocess.h"
+
+#include <memory>
+#include <vector>
+
+// Satellites started ahead of time, each running one job at a time in a
+// fresh Lua state so scripts don't pay for a spawn
+class SatellitePool {
+	unsigned int size;
+	std::vector<std::shared_ptr<ChildProcess>> idle;
+	std::vector<std::shared_ptr<ChildProcess>> busy;
+
+	// Soft limits applied before every job, RLIM_INFINITY if unset
+	rlim_t cpuLimit = RLIM_INFINITY;
+	rlim_t memoryLimit = RLIM_INFINITY;
+	rlim_t fileSizeLimit = RLIM_INFINITY;
+
+	unsigned int numSpawned = 0;
+	unsigned int numHits = 0;
+	unsigned int numReplaced = 0;
+	unsigned int numMisses = 0;
+	unsigned int numJobs = 0;
+
+	std::shared_ptr<ChildProcess> spawn();
+	bool applyLimits(ChildProcess* child);
+	std::shared_ptr<ChildProcess> acquire(Framing::Control control,
+	                                      const std::string& source);
+
+ public:
+	SatellitePool(unsigned int size);
+	// Runs a file in an idle satellite, spawning one if none are idle
+	std::shared_ptr<ChildProcess> acquireFile(std::string fileName);
+	// Runs Lua source in an idle satellite, spawning one if none are idle
+	std::shared_ptr<ChildProcess> acquireChunk(std::string source);
+	// Returns a satellite whose job has finished to the pool, anything else is
+	// terminated and replaced
+	void release(std::shared_ptr<ChildProcess> child);
+	void setCPULimit(rlim_t seconds);
+	void setMemoryLimit(rlim_t bytes);
+	void setFileSizeLimit(rlim_t bytes);
+	sol::table getStats(sol::this_state s) const;
+};
@@ -0,0 +1,298 @@
+#include "sharedtable.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static constexpr size_t numBuckets = 1024;
+
+struct SharedValue {
+	sol::type type = sol::type::lua_nil;
+	bool boolean;
+	double number;
+	std::string string;
+
+	bool operator==(const SharedValue& other) const {
+		if (type != other.type) return false;
+		switch (type) {
+			case sol::type::boolean:
+				return boolean == other.boolean;
+			case sol::type::number:
+				return number == other.number;
+			case sol::type::string:
+				return string == other.string;
+			default:
+				return true;
+		}
+	}
+};
+
+struct SharedEntry {
+	std::string key;
+	SharedValue value;
+};
+
+// Never modified once published, writers replace the whole bucket
+using SharedBucket = std::vector<SharedEntry>;
+
+// Keys are tagged so 1 and "1" don't collide
+static std::string toKey(const sol::object& key) {
+	std::string encoded;
+	switch (key.get_type()) {
+		case sol::type::string:
+			encoded.push_back('s');
+			encoded.append(key.as<std::string>());
+			break;
+		case sol::type::number: {
+			double number = key.as<double>();
+			if (std::isnan(number)) throw std::invalid_argument("Key is NaN");
+			// -0 and 0 are the same key
+			if (number == 0) number = 0;
+			encoded.push_back('n');
+			encoded.append(reinterpret_cast<const char*>(&number), sizeof(number));
+			break;
+		}
+		default:
+			throw std::invalid_argument("Key must be a string or number");
+	}
+	return encoded;
+}
+
+static SharedValue toValue(const sol::object& object) {
+	SharedValue value;
+	value.type = object.get_type();
+	switch (value.type) {
+		case sol::type::lua_nil:
+		case sol::type::none:
+			value.type = sol::type::lua_nil;
+			break;
+		case sol::type::boolean:
+			value.boolean = object.as<bool>();
+			break;
+		case sol::type::number:
+			value.number = object.as<double>();
+			break;
+		case sol::type::string:
+			value.string = object.as<std::string>();
+			break;
+		default:
+			throw std::invalid_argument(
+			    "Value must be nil, a boolean, a number or a string");
+	}
+	return value;
+}
+
+static sol::object toObject(sol::state_view lua, SharedValue&& value) {
+	switch (value.type) {
+		case sol::type::boolean:
+			return sol::make_object(lua, value.boolean);
+		case sol::type::number:
+			return sol::make_object(lua, value.number);
+		case sol::type::string:
+			return sol::make_object(lua, std::move(value.string));
+		default:
+			return sol::make_object(lua, sol::lua_nil);
+	}
+}
+
+struct SharedTable::Store {
+	struct alignas(64) Slot {
+		std::atomic<const SharedBucket*> bucket{nullptr};
+		std::mutex writeMutex;
+	};
+
+	Slot slots[numBuckets];
+	std::atomic_size_t size{0};
+
+	// Two reader counters, flipped between by writers to find out when every
+	// reader that could still see an old bucket has left (as in userspace RCU)
+	std::atomic_uint epoch{0};
+	alignas(64) std::atomic_uint readers[2] = {};
+
+	struct RetiredBucket {
+		unsigned int epoch;
+		const SharedBucket* bucket;
+	};
+
+	// Replaced buckets, oldest first, freed by later writes once it's safe
+	std::mutex reclaimMutex;
+	std::deque<RetiredBucket> retired;
+
+	~Store() {
+		for (auto& slot : slots) delete slot.bucket.load();
+		for (auto& entry : retired) delete entry.bucket;
+	}
+
+	Slot& slotFor(const std::string& key) {
+		return slots[std::hash<std::string>{}(key) & (numBuckets - 1)];
+	}
+
+	unsigned int beginRead() {
+		unsigned int parity = epoch.load() & 1;
+		readers[parity].fetch_add(1);
+		return parity;
+	}
+
+	void endRead(unsigned int parity) {
+		readers[parity].fetch_sub(1, std::memory_order_release);
+	}
+
+	// Queues a bucket that's been swapped out, and frees whatever no reader can
+	// be holding any more. Never waits for readers.
+	void retire(const SharedBucket* old) {
+		if (!old) return;
+
+		std::vector<const SharedBucket*> freeable;
+		{
+			std::lock_guard<std::mutex> guard(reclaimMutex);
+			retired.push_back({epoch.load(), old});
+
+			// Readers only join the current parity, so once the other one drains
+			// it's safe to flip. A reader can have read a stale epoch just before
+			// counting itself, so an old bucket could be held under either parity,
+			// and it takes two flips to be sure.
+			unsigned int current = epoch.load();
+			if (!readers[(current + 1) & 1].load()) epoch.store(++current);
+
+			while (!retired.empty() && current - retired.front().epoch >= 2) {
+				freeable.push_back(retired.front().bucket);
+				retired.pop_front();
+			}
+		}
+
+		for (auto bucket : freeable) delete bucket;
+	}
+
+	bool find(const std::string& key, SharedValue& out) {
+		unsigned int parity = beginRead();
+		const SharedBucket* bucket = slotFor(key).bucket.load();
+
+		bool found = false;
+		if (bucket) {
+			for (const auto& entry : *bucket) {
+				if (entry.key == key) {
+					out = entry.value;
+					found = true;
+					break;
+				}
+			}
+		}
+
+		endRead(parity);
+		return found;
+	}
+
+	// Runs update on the current value (nil if missing) with the bucket locked.
+	// It returns false to leave the bucket unchanged.
+	bool modify(const std::string& key,
+	            const std::function<bool(SharedValue&)>& update) {
+		Slot& slot = slotFor(key);
+		const SharedBucket* old;
+
+		{
+			std::lock_guard<std::mutex> guard(slot.writeMutex);
+			old = slot.bucket.load(std::memory_order_relaxed);
+
+			auto copy = old ? std::make_unique<SharedBucket>(*old)
+			                : std::make_unique<SharedBucket>();
+			auto it = copy->begin();
+			while (it != copy->end() && it->key != key) ++it;
+
+			bool existed = it != copy->end();
+			SharedValue value;
+			if (existed) value = it->value;
+
+			if (!update(value)) return false;
+
+			if (value.type == sol::type::lua_nil) {
+				if (!existed) return true;
+				copy->erase(it);
+				size.fetch_sub(1, std::memory_order_relaxed);
+			} else if (existed) {
+				it->value = std::move(value);
+			} else {
+				copy->push_back({key, std::move(value)});
+				size.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			if (copy->empty()) copy.reset();
+			slot.bucket.store(copy.release());
+		}
+
+		retire(old);
+		return true;
+	}
+};
+
+SharedTable SharedTable::get(const std::string& name) {
+	static std::mutex registryMutex;
+	static std::map<std::string, std::unique_ptr<Store>> registry;
+
+	std::lock_guard<std::mutex> guard(registryMutex);
+	auto& store = registry[name];
+	if (!store) store = std::make_unique<Store>();
+	return SharedTable(store.get());
+}
+
+sol::object SharedTable::getValue(sol::object key, sol::this_state s) const {
+	SharedValue value;
+	store->find(toKey(key), value);
+	return toObject(s, std::move(value));
+}
+
+void SharedTable::set(sol::object key, sol::object value) {
+	SharedValue newValue = toValue(value);
+	store->modify(toKey(key), [&](SharedValue& current) {
+		current = std::move(newValue);
+		return true;
+	});
+}
+
+bool SharedTable::remove(sol::object key) {
+	bool existed = false;
+	store->modify(toKey(key), [&](SharedValue& current) {
+		existed = current.type != sol::type::lua_nil;
+		current = SharedValue();
+		return existed;
+	});
+	return existed;
+}
+
+double SharedTable::increment(sol::object key, sol::optional<double> delta) {
+	double result;
+	store->modify(toKey(key), [&](SharedValue& current) {
+		if (current.type == sol::type::lua_nil) {
+			current.type = sol::type::number;
+			current.number = 0;
+		} else if (current.type != sol::type::number) {
+			throw std::invalid_argument("Value is not a number");
+		}
+
+		current.number += delta.value_or(1);
+		result = current.number;
+		return true;
+	});
+	return result;
+}
+
+bool SharedTable::compareAndSet(sol::object key, sol::object expected,
+                                sol::object value) {
+	SharedValue expectedValue = toValue(expected);
+	SharedValue newValue = toValue(value);
+
+	return store->modify(toKey(key), [&](SharedValue& current) {
+		if (!(current == expectedValue)) return false;
+		current = std::move(newValue);
+		return true;
+	});
+}
+
+size_t SharedTable::getSize() const {
+	return store->size.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "sol/sol.hpp"
+
+#include <string>
+
+// A named hash map shared by every state in the process. Values are nil,
+// booleans, numbers and strings. Reads never lock; writes lock one bucket.
+class SharedTable {
+	struct Store;
+	Store* store;
+
+	SharedTable(Store* store) : store(store) {}
+
+ public:
+	// Tables are created on first use and live as long as the process
+	static SharedTable get(const std::string& name);
+
+	sol::object getValue(sol::object key, sol::this_state s) const;
+	// Setting nil deletes the key
+	void set(sol::object key, sol::object value);
+	// Returns true if the key existed
+	bool remove(sol::object key);
+	// Treats a missing key as 0, returns the new value
+	double increment(sol::object key, sol::optional<double> delta);
+	// Sets only if the current value equals expected, where nil means missing
+	bool compareAndSet(sol::object key, sol::object expected, sol::object value);
+	size_t getSize() const;
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include "futex.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Bounded single producer, single consumer queue of move-only values. The
+// consumer can block until something arrives; the producer never blocks and is
+// told when the ring is full instead.
+template <typename T>
+class SPSCRing {
+	static constexpr size_t cacheLineSize = 64;
+	static constexpr int spinIterations = 1024;
+
+	const size_t mask;
+	std::unique_ptr<T[]> slots;
+
+	alignas(cacheLineSize) std::atomic_size_t head{0};
+	size_t cachedTail = 0;
+
+	alignas(cacheLineSize) std::atomic_size_t tail{0};
+	size_t cachedHead = 0;
+
+	// Bumped on every push and on close, so a sleeping consumer can tell
+	alignas(cacheLineSize) std::atomic_uint32_t sequence{0};
+	std::atomic_uint32_t numWaiters{0};
+	std::atomic_bool closed{false};
+
+	void wake() {
+		sequence.fetch_add(1);
+		if (numWaiters.load()) futexWakeAll(&sequence);
+	}
+
+ public:
+	// Capacity is rounded up to a power of two
+	explicit SPSCRing(size_t minCapacity)
+	    : mask([minCapacity] {
+		      size_t capacity = 1;
+		      while (capacity < minCapacity) capacity <<= 1;
+		      return capacity - 1;
+	      }()),
+	      slots(new T[mask + 1]) {}
+
+	size_t capacity() const { return mask + 1; }
+
+	// From any thread, so only approximate while the ring is in use
+	size_t size() const {
+		// Head first, since it never passes tail. Read the other way round, a pop
+		// in between could leave head ahead and the difference would wrap.
+		size_t currentHead = head.load(std::memory_order_acquire);
+		size_t currentTail = tail.load(std::memory_order_acquire);
+		return currentTail >= currentHead ? currentTail - currentHead : 0;
+	}
+
+	// Producer only. Leaves value untouched and returns false if full.
+	bool push(T&& value) {
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (currentTail - cachedHead > mask) {
+			cachedHead = head.load(std::memory_order_acquire);
+			if (currentTail - cachedHead > mask) return false;
+		}
+
+		slots[currentTail & mask] = std::move(value);
+		tail.store(currentTail + 1, std::memory_order_release);
+		wake();
+		return true;
+	}
+
+	// Consumer only
+	bool pop(T& value) {
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead == cachedTail) {
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (currentHead == cachedTail) return false;
+		}
+
+		value = std::move(slots[currentHead & mask]);
+		head.store(currentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only. Waits up to timeoutMs (negative waits forever) for a value,
+	// giving up early once the ring is closed and empty.
+	bool waitPop(T& value, int timeoutMs) {
+		if (pop(value)) return true;
+		if (!timeoutMs) return false;
+
+		// A value is often only moments away, which is far cheaper to spin for
+		// than to sleep for, unless spinning keeps the producer off the only core
+		static const int numSpins =
+		    std::thread::hardware_concurrency() > 1 ? spinIterations : 0;
+		for (int i = 0; i < numSpins; i++) {
+			__builtin_ia32_pause();
+			if (pop(value)) return true;
+		}
+
+		auto deadline = std::chrono::steady_clock::now() +
+		                std::chrono::milliseconds(timeoutMs);
+
+		while (true) {
+			numWaiters.fetch_add(1);
+			uint32_t seen = sequence.load();
+
+			int remainingMs = -1;
+			if (timeoutMs > 0) {
+				remainingMs = std::chrono::ceil<std::chrono::milliseconds>(
+				                  deadline - std::chrono::steady_clock::now())
+				                  .count();
+			}
+
+			if (pop(value)) {
+				numWaiters.fetch_sub(1);
+				return true;
+			}
+			if (closed.load() || (timeoutMs > 0 && remainingMs <= 0)) {
+				numWaiters.fetch_sub(1);
+				return false;
+			}
+
+			futexWait(&sequence, seen, remainingMs);
+			numWaiters.fetch_sub(1);
+		}
+	}
+
+	// Wakes the consumer and stops it waiting from then on, from any thread
+	void close() {
+		closed.store(true);
+		wake();
+	}
+
+	bool isClosed() const { return closed.load(); }
+};
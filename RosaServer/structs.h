@@ -60,6 +60,10 @@ struct Vector {
 	void mult(float scalar);
 	void set(Vector* other);
 	void cross(Vector* other);
+	void addScaled(Vector* other, float scalar);
+	void lerpTo(Vector* other, float t);
+	void rotateBy(RotMatrix* rot);
+	void transformInto(RotMatrix* rot, Vector* out) const;
 	Vector clone() const;
 	float dist(Vector* other) const;
 	float distSquare(Vector* other) const;
@@ -79,6 +83,10 @@ struct RotMatrix {
 	std::string __tostring() const;
 	RotMatrix __mul(RotMatrix* other) const;
 	void set(RotMatrix* other);
+	void rotateBy(RotMatrix* other);
+	void orthonormalize();
+	void fromEuler(float rotX, float rotY, float rotZ);
+	void slerp(RotMatrix* other, float t);
 	RotMatrix clone() const;
 	Vector getForward() const;
 	Vector getUp() const;
@@ -0,0 +1,271 @@
+#include "webhook.h"
+#include "httpclient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace Webhook {
+using Clock = std::chrono::steady_clock;
+
+static constexpr std::chrono::milliseconds baseBackoff(500);
+static constexpr std::chrono::milliseconds maxBackoff(60 * 1000);
+// Far enough for any sane server, and keeps huge values from overflowing
+static constexpr std::chrono::seconds maxRetryAfter(60 * 60);
+// Each endpoint has at most one batch in flight, so this many endpoints that
+// hang can hold up the rest
+static constexpr int numSenders = 4;
+
+struct QueuedMessage {
+	std::string body;
+	Clock::time_point queuedAt;
+};
+
+struct Endpoint {
+	std::string scheme;
+	std::string path;
+	Options options;
+	std::deque<QueuedMessage> messages;
+	// Includes the batch being sent, which only leaves once it's done with
+	size_t queuedBytes = 0;
+	unsigned int numSending = 0;
+	Clock::time_point notBefore;
+	unsigned int attempts = 0;
+	Clock::time_point lastServed;
+	uint64_t sent = 0;
+	uint64_t failed = 0;
+	uint64_t dropped = 0;
+	uint64_t retries = 0;
+};
+
+static std::unordered_map<std::string, Endpoint> endpoints;
+static std::mutex endpointsMutex;
+static std::condition_variable endpointsCondition;
+static bool sendersStarted = false;
+
+static bool isReady(const Endpoint& endpoint, Clock::time_point now) {
+	if (endpoint.numSending || endpoint.messages.empty()) return false;
+	if (now < endpoint.notBefore) return false;
+
+	const auto& options = endpoint.options;
+	return endpoint.messages.size() >= options.maxBatchMessages ||
+	       endpoint.queuedBytes >= options.maxBatchBytes ||
+	       now - endpoint.messages.front().queuedAt >=
+	           std::chrono::milliseconds(options.flushMs);
+}
+
+static Clock::time_point getWakeTime(const Endpoint& endpoint) {
+	return std::max(endpoint.notBefore,
+	                endpoint.messages.front().queuedAt +
+	                    std::chrono::milliseconds(endpoint.options.flushMs));
+}
+
+static Clock::duration getBackoff(unsigned int attempts) {
+	auto backoff = baseBackoff * (1u << std::min(attempts - 1, 16u));
+	return std::min<Clock::duration>(backoff, maxBackoff);
+}
+
+// Either a number of seconds or an HTTP-date
+static bool parseRetryAfter(const std::string& value,
+                            Clock::duration& retryAfter) {
+	if (value.empty()) return false;
+
+	char* end;
+	double seconds = std::strtod(value.c_str(), &end);
+	if (*end) {
+		tm date{};
+		if (!strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &date))
+			return false;
+		seconds = std::difftime(timegm(&date), std::time(nullptr));
+	}
+
+	if (!std::isfinite(seconds)) return false;
+	seconds = std::min<double>(std::max(seconds, 0.), maxRetryAfter.count());
+
+	retryAfter = std::chrono::duration_cast<Clock::duration>(
+	    std::chrono::duration<double>(seconds));
+	return true;
+}
+
+static std::string joinBatch(const Options& options,
+                             const std::vector<QueuedMessage>& batch) {
+	std::string body = options.prefix;
+	for (size_t i = 0; i < batch.size(); i++) {
+		if (i) body += options.separator;
+		body += batch[i].body;
+	}
+	body += options.suffix;
+	return body;
+}
+
+// Called with the lock held, returns the batch's messages to the front of the
+// queue in their original order
+static void requeueBatch(Endpoint& endpoint,
+                         std::vector<QueuedMessage>& batch) {
+	for (auto it = batch.rbegin(); it != batch.rend(); ++it)
+		endpoint.messages.push_front(std::move(*it));
+}
+
+static void sendBatch(std::unique_lock<std::mutex>& lock, Endpoint& endpoint) {
+	const auto& options = endpoint.options;
+
+	std::vector<QueuedMessage> batch;
+	size_t batchBytes = 0;
+	while (!endpoint.messages.empty() &&
+	       batch.size() < options.maxBatchMessages) {
+		size_t size = endpoint.messages.front().body.size();
+		if (!batch.empty() && batchBytes + size > options.maxBatchBytes) break;
+
+		batchBytes += size;
+		batch.push_back(std::move(endpoint.messages.front()));
+		endpoint.messages.pop_front();
+	}
+	endpoint.numSending = batch.size();
+	endpoint.lastServed = Clock::now();
+
+	LuaHTTPRequest request;
+	request.type = LuaRequestType::post;
+	request.scheme = endpoint.scheme;
+	request.path = endpoint.path;
+	request.contentType = options.contentType;
+	request.body = joinBatch(options, batch);
+
+	lock.unlock();
+	auto res = HTTPClient::perform(request);
+	lock.lock();
+
+	endpoint.numSending = 0;
+	auto now = Clock::now();
+
+	if (res && res->status >= 200 && res->status <= 299) {
+		endpoint.sent += batch.size();
+		endpoint.queuedBytes -= batchBytes;
+		endpoint.attempts = 0;
+		return;
+	}
+
+	bool retryable = !res || res->status == 408 || res->status == 429 ||
+	                 res->status >= 500;
+	if (retryable && endpoint.attempts < options.maxRetries) {
+		endpoint.attempts++;
+		endpoint.retries++;
+
+		Clock::duration delay = getBackoff(endpoint.attempts);
+		Clock::duration retryAfter;
+		if (res && res->status == 429 &&
+		    parseRetryAfter(res->get_header_value("Retry-After"), retryAfter))
+			delay = retryAfter;
+
+		endpoint.notBefore = now + delay;
+		requeueBatch(endpoint, batch);
+		return;
+	}
+
+	endpoint.failed += batch.size();
+	endpoint.queuedBytes -= batchBytes;
+	endpoint.attempts = 0;
+}
+
+// Every sender runs this, picking whichever endpoint is ready and not already
+// being sent to by another
+static void senderMain() {
+	std::unique_lock<std::mutex> lock(endpointsMutex);
+	while (true) {
+		auto now = Clock::now();
+		Endpoint* ready = nullptr;
+		Clock::time_point wakeTime = Clock::time_point::max();
+
+		// The least recently served goes first, so one that's always ready
+		// can't starve the rest
+		for (auto& pair : endpoints) {
+			Endpoint& endpoint = pair.second;
+			if (isReady(endpoint, now)) {
+				if (!ready || endpoint.lastServed < ready->lastServed)
+					ready = &endpoint;
+			} else if (!endpoint.numSending && !endpoint.messages.empty()) {
+				wakeTime = std::min(wakeTime, getWakeTime(endpoint));
+			}
+		}
+
+		if (ready)
+			sendBatch(lock, *ready);
+		else if (wakeTime == Clock::time_point::max())
+			endpointsCondition.wait(lock);
+		else
+			endpointsCondition.wait_until(lock, wakeTime);
+	}
+}
+
+// Called with the lock held
+static Endpoint& getEndpoint(const std::string& url) {
+	auto it = endpoints.find(url);
+	if (it != endpoints.end()) return it->second;
+
+	Endpoint endpoint;
+	HTTPClient::splitURL(url, endpoint.scheme, endpoint.path);
+
+	if (!sendersStarted) {
+		sendersStarted = true;
+		for (int i = 0; i < numSenders; i++) {
+			std::thread thread(senderMain);
+			thread.detach();
+		}
+	}
+
+	return endpoints.emplace(url, std::move(endpoint)).first->second;
+}
+
+bool enqueue(const std::string& url, std::string&& body) {
+	{
+		std::lock_guard<std::mutex> guard(endpointsMutex);
+		Endpoint& endpoint = getEndpoint(url);
+
+		if (endpoint.queuedBytes + body.size() > endpoint.options.maxQueuedBytes) {
+			endpoint.dropped++;
+			return false;
+		}
+
+		endpoint.queuedBytes += body.size();
+		endpoint.messages.push_back({std::move(body), Clock::now()});
+	}
+	endpointsCondition.notify_one();
+	return true;
+}
+
+Options getOptions(const std::string& url) {
+	std::lock_guard<std::mutex> guard(endpointsMutex);
+	auto it = endpoints.find(url);
+	return it == endpoints.end() ? Options() : it->second.options;
+}
+
+void setOptions(const std::string& url, const Options& options) {
+	if (!options.maxBatchMessages)
+		throw std::invalid_argument("maxBatchMessages must be at least 1");
+
+	{
+		std::lock_guard<std::mutex> guard(endpointsMutex);
+		getEndpoint(url).options = options;
+	}
+	endpointsCondition.notify_one();
+}
+
+bool getStats(const std::string& url, Stats& stats) {
+	std::lock_guard<std::mutex> guard(endpointsMutex);
+	auto it = endpoints.find(url);
+	if (it == endpoints.end()) return false;
+
+	const Endpoint& endpoint = it->second;
+	stats.queued = endpoint.messages.size() + endpoint.numSending;
+	stats.queuedBytes = endpoint.queuedBytes;
+	stats.sent = endpoint.sent;
+	stats.failed = endpoint.failed;
+	stats.dropped = endpoint.dropped;
+	stats.retries = endpoint.retries;
+	return true;
+}
+}  // namespace Webhook
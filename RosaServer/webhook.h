@@ -0,0 +1,35 @@
+#pragma once
+#include "api.h"
+
+// Batches outgoing messages per endpoint and delivers them on a few background
+// threads, one batch per endpoint at a time, so a slow endpoint only holds up
+// the others once every sender is stuck on one. Safe to use from any thread.
+namespace Webhook {
+struct Options {
+	unsigned int maxBatchMessages = 10;
+	size_t maxBatchBytes = 64 * 1024;
+	unsigned int flushMs = 1000;
+	size_t maxQueuedBytes = 1024 * 1024;
+	unsigned int maxRetries = 5;
+	std::string prefix = "[";
+	std::string separator = ",";
+	std::string suffix = "]";
+	std::string contentType = "application/json";
+};
+
+struct Stats {
+	unsigned int queued;
+	size_t queuedBytes;
+	uint64_t sent;
+	uint64_t failed;
+	uint64_t dropped;
+	uint64_t retries;
+};
+
+// Returns false if the endpoint's queue is full and the message was dropped
+bool enqueue(const std::string& url, std::string&& body);
+Options getOptions(const std::string& url);
+void setOptions(const std::string& url, const Options& options);
+// Returns false if nothing has been sent to or configured for the URL
+bool getStats(const std::string& url, Stats& stats);
+}  // namespace Webhook
@@ -1,113 +1,273 @@
 #include "worker.h"
 #include "api.h"
+#include "serialize.h"
 
-#include <iostream>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <chrono>
 #include <thread>
 
-Worker::Worker(std::string fileName) {
-	stopped = new std::atomic_bool(false);
+// pthread_setname_np's limit, not counting the terminator
+static constexpr size_t maxThreadNameLength = 15;
+// How long collecting a worker waits for its script to stop
+static constexpr std::chrono::milliseconds stopTimeout(100);
 
-	std::thread thread(&Worker::runThread, this, fileName);
-	thread.detach();
+Worker::Worker(std::string fileName) : Worker(fileName, sol::table()) {}
+
+Worker::Worker(std::string fileName, sol::table options)
+    : channel(std::make_shared<Channel>()),
+      lastStatsTime(std::chrono::steady_clock::now()) {
+	std::promise<void> started;
+	std::future<void> result = started.get_future();
+	thread = std::thread(&Worker::runThread, channel, fileName,
+	                     parseOptions(options), std::move(started));
+
+	try {
+		result.get();
+	} catch (...) {
+		// The thread returns right after failing, and only holds the channel
+		thread.detach();
+		throw;
+	}
 }
 
 Worker::~Worker() {
-	std::lock_guard<std::mutex> guard(destructionMutex);
 	stop();
+
+	// A script stuck in a JIT-compiled loop or a blocking call never sees the
+	// interrupt. Rather than hang the tick in a finalizer, leave it running; it
+	// keeps the channel alive itself.
+	auto deadline = std::chrono::steady_clock::now() + stopTimeout;
+	while (!channel->finished && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	if (channel->finished)
+		thread.join();
+	else
+		thread.detach();
 }
 
-void Worker::runThread(std::string fileName) {
-	std::atomic_bool* _stopped = stopped;
+Worker::ThreadOptions Worker::parseOptions(sol::table options) {
+	ThreadOptions parsed;
+	if (!options.valid()) return parsed;
 
-	sol::state state;
-	defineThreadSafeAPIs(&state);
+	sol::optional<std::string> name = options["name"];
+	if (name) {
+		if (name->length() > maxThreadNameLength)
+			throw std::invalid_argument("Worker name is too long");
+		parsed.name = *name;
+	}
 
-	state["sendMessage"] = [this](std::string message) {
-		this->l_sendMessage(message);
-	};
+	sol::optional<sol::table> cpus = options["cpus"];
+	if (cpus) {
+		CPU_ZERO(&parsed.cpus);
 
-	state["receiveMessage"] = [this](sol::this_state s) {
-		return this->l_receiveMessage(s);
-	};
+		size_t length = cpus->size();
+		if (!length) throw std::invalid_argument("CPU list is empty");
+		for (size_t i = 1; i <= length; i++) {
+			int cpu = cpus->get<int>(i);
+			if (cpu < 0 || cpu >= CPU_SETSIZE)
+				throw std::invalid_argument("CPU index out of range");
+			CPU_SET(cpu, &parsed.cpus);
+		}
+		parsed.hasCPUs = true;
+	}
 
-	destructionMutex.lock();
+	parsed.nice = options.get<sol::optional<int>>("nice");
+	return parsed;
+}
 
-	state["sleep"] = [this, &_stopped](unsigned int ms) -> bool {
-		// Allow this to be deconstructed while sleeping
-		this->destructionMutex.unlock();
-		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+void Worker::applyOptions(const ThreadOptions& options) {
+	int err = pthread_setname_np(pthread_self(), options.name.c_str());
+	if (err) throw std::runtime_error(strerror(err));
 
-		if (*_stopped) return true;
+	// Threads inherit the creator's affinity, which would pin every worker to
+	// the main thread's core under taskset
+	if (options.hasCPUs) {
+		err = pthread_setaffinity_np(pthread_self(), sizeof(options.cpus),
+		                             &options.cpus);
+		if (err) throw std::runtime_error(strerror(err));
+	}
 
-		this->destructionMutex.lock();
-		return false;
-	};
+	// Linux applies nice values per thread, by thread ID
+	if (options.nice) {
+		pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+		if (setpriority(PRIO_PROCESS, tid, *options.nice) == -1)
+			throw std::runtime_error(strerror(errno));
+	}
+}
+
+void Worker::interruptHook(lua_State* L, lua_Debug*) {
+	luaL_error(L, "Worker was stopped");
+}
+
+void Worker::runThread(std::shared_ptr<Channel> channel, std::string fileName,
+                       ThreadOptions options, std::promise<void> started) {
+	try {
+		applyOptions(options);
+	} catch (...) {
+		started.set_exception(std::current_exception());
+		return;
+	}
+	started.set_value();
+
+	Channel* ch = channel.get();
 
 	{
+		sol::state state;
+		defineThreadSafeAPIs(&state);
+
+		state["sendMessage"] = [ch](std::string message) {
+			if (!ch->fromWorker.push(std::move(message))) return false;
+			ch->numReceived.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		};
+
+		state["receiveMessage"] = [ch](sol::optional<int> timeoutMs,
+		                               sol::this_state s) {
+			sol::state_view state(s);
+
+			std::string message;
+			if (!ch->toWorker.waitPop(message, timeoutMs.value_or(0)))
+				return sol::make_object(state, sol::lua_nil);
+			return sol::make_object(state, std::move(message));
+		};
+
+		state["sendValue"] = [ch](sol::object value) {
+			if (!ch->fromWorker.push(Serialize::encode(value, getSerializeCodec())))
+				return false;
+			ch->numReceived.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		};
+
+		state["receiveValue"] = [ch](sol::optional<int> timeoutMs,
+		                             sol::this_state s) {
+			std::string encoded;
+			if (!ch->toWorker.waitPop(encoded, timeoutMs.value_or(0)))
+				return sol::make_object(s, sol::lua_nil);
+			return Serialize::decode(s, encoded, getSerializeCodec());
+		};
+
+		state["sleep"] = [ch](unsigned int ms) -> bool {
+			auto deadline =
+			    std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+
+			// Wakes as soon as the worker is stopped
+			while (!ch->stopped) {
+				auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+				    deadline - std::chrono::steady_clock::now());
+				if (remaining.count() <= 0) return false;
+				futexWait(&ch->stopped, 0, remaining.count());
+			}
+
+			return true;
+		};
+
+		{
+			std::lock_guard<std::mutex> guard(ch->stateMutex);
+			ch->luaState = state.lua_state();
+			if (ch->stopped)
+				lua_sethook(ch->luaState, interruptHook, LUA_MASKCOUNT, 1);
+		}
+
 		sol::load_result load = state.load_file(fileName);
 		if (noLuaCallError(&load)) {
 			sol::protected_function_result res = load();
-			noLuaCallError(&res);
+			// Being interrupted by stop() isn't worth reporting
+			if (!ch->stopped) noLuaCallError(&res);
 		}
-	}
 
-	if (!*_stopped) {
-		destructionMutex.unlock();
+		std::lock_guard<std::mutex> guard(ch->stateMutex);
+		ch->luaState = nullptr;
 	}
 
-	while (!*_stopped) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-	}
+	timespec cpuTime;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime) == 0)
+		ch->finalCPUNanoseconds = cpuTime.tv_sec * 1000000000LL + cpuTime.tv_nsec;
+	ch->finished = true;
+}
+
+void Worker::stop() {
+	if (channel->stopped.exchange(1)) return;
+
+	futexWakeAll(&channel->stopped);
+	channel->toWorker.close();
 
-	delete _stopped;
+	// Makes a busy script error out at its next instruction. lua_sethook is
+	// safe to call from another thread.
+	std::lock_guard<std::mutex> guard(channel->stateMutex);
+	if (channel->luaState)
+		lua_sethook(channel->luaState, interruptHook, LUA_MASKCOUNT, 1);
 }
 
-void Worker::l_sendMessage(std::string message) {
-	std::lock_guard<std::mutex> guard(receiveMessageQueueMutex);
-	receiveMessageQueue.push(message);
-	if (receiveMessageQueue.size() > 2047) receiveMessageQueue.pop();
+bool Worker::sendMessage(std::string message) {
+	if (channel->stopped) return false;
+	if (!channel->toWorker.push(std::move(message))) return false;
+	channel->numSent.fetch_add(1, std::memory_order_relaxed);
+	return true;
 }
 
-sol::object Worker::l_receiveMessage(sol::this_state s) {
+sol::object Worker::receiveMessage(sol::this_state s) {
 	sol::state_view state(s);
 
-	sendMessageQueueMutex.lock();
-	if (sendMessageQueue.empty()) {
-		sendMessageQueueMutex.unlock();
+	std::string message;
+	if (!channel->fromWorker.pop(message))
 		return sol::make_object(state, sol::lua_nil);
-	}
-
-	auto message = sendMessageQueue.front();
-	sendMessageQueue.pop();
-	sendMessageQueueMutex.unlock();
-	return sol::make_object(state, message);
+	return sol::make_object(state, std::move(message));
 }
 
-void Worker::stop() {
-	if (stopped && !*stopped) {
-		*stopped = true;
-	}
+bool Worker::sendValue(sol::object value) {
+	if (channel->stopped) return false;
+	if (!channel->toWorker.push(Serialize::encode(value, getSerializeCodec())))
+		return false;
+	channel->numSent.fetch_add(1, std::memory_order_relaxed);
+	return true;
 }
 
-void Worker::sendMessage(std::string message) {
-	if (stopped && *stopped) return;
-
-	std::lock_guard<std::mutex> guard(sendMessageQueueMutex);
-	sendMessageQueue.push(message);
-	if (sendMessageQueue.size() > 2047) sendMessageQueue.pop();
+sol::object Worker::receiveValue(sol::this_state s) {
+	std::string encoded;
+	if (!channel->fromWorker.pop(encoded))
+		return sol::make_object(s, sol::lua_nil);
+	return Serialize::decode(s, encoded, getSerializeCodec());
 }
 
-sol::object Worker::receiveMessage(sol::this_state s) {
-	sol::state_view state(s);
+sol::table Worker::getStats(sol::this_state s) {
+	sol::state_view lua(s);
 
-	receiveMessageQueueMutex.lock();
-	if (receiveMessageQueue.empty()) {
-		receiveMessageQueueMutex.unlock();
-		return sol::make_object(state, sol::lua_nil);
+	auto now = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(now - lastStatsTime).count();
+	uint64_t numSent = channel->numSent.load(std::memory_order_relaxed);
+	uint64_t numReceived = channel->numReceived.load(std::memory_order_relaxed);
+
+	bool running = !channel->finished;
+	double cpuSeconds = channel->finalCPUNanoseconds / 1e9;
+	if (running) {
+		clockid_t clock;
+		timespec cpuTime;
+		if (pthread_getcpuclockid(thread.native_handle(), &clock) == 0 &&
+		    clock_gettime(clock, &cpuTime) == 0)
+			cpuSeconds = cpuTime.tv_sec + cpuTime.tv_nsec / 1e9;
 	}
 
-	auto message = receiveMessageQueue.front();
-	receiveMessageQueue.pop();
-	receiveMessageQueueMutex.unlock();
-	return sol::make_object(state, message);
+	sol::table stats = lua.create_table(0, 9);
+	stats["running"] = running;
+	stats["queueCapacity"] = queueCapacity;
+	stats["toWorkerQueued"] = channel->toWorker.size();
+	stats["fromWorkerQueued"] = channel->fromWorker.size();
+	stats["messagesSent"] = numSent;
+	stats["messagesReceived"] = numReceived;
+	// Since the previous call, or since the worker started
+	stats["sentPerSecond"] = seconds > 0 ? (numSent - lastNumSent) / seconds : 0.;
+	stats["receivedPerSecond"] =
+	    seconds > 0 ? (numReceived - lastNumReceived) / seconds : 0.;
+	stats["cpuSeconds"] = cpuSeconds;
+
+	lastStatsTime = now;
+	lastNumSent = numSent;
+	lastNumReceived = numReceived;
+
+	return stats;
 }
\ No newline at end of file
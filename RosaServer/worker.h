@@ -1,29 +1,72 @@
 #pragma once
 #include "sol/sol.hpp"
+#include "spscring.h"
 
+#include <sched.h>
 #include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
+#include <thread>
 
 class Worker {
-	std::atomic_bool* stopped = nullptr;
-	std::mutex destructionMutex;
+	static constexpr size_t queueCapacity = 2048;
 
-	std::queue<std::string> sendMessageQueue;
-	std::mutex sendMessageQueueMutex;
+	// Owned jointly with the thread, so neither side has to outlive the other
+	struct Channel {
+		SPSCRing<std::string> toWorker;
+		SPSCRing<std::string> fromWorker;
+		std::atomic_uint32_t stopped{0};
+		std::atomic_bool finished{false};
 
-	std::queue<std::string> receiveMessageQueue;
-	std::mutex receiveMessageQueueMutex;
+		std::atomic_uint64_t numSent{0};
+		std::atomic_uint64_t numReceived{0};
+		// Recorded by the thread on its way out, when its clock goes away
+		std::atomic_int64_t finalCPUNanoseconds{0};
 
-	void runThread(std::string fileName);
-	void l_sendMessage(std::string message);
-	sol::object l_receiveMessage(sol::this_state s);
+		// Guards the state's lifetime so stop() can interrupt running code
+		std::mutex stateMutex;
+		lua_State* luaState = nullptr;
+
+		Channel() : toWorker(queueCapacity), fromWorker(queueCapacity) {}
+	};
+
+	// Applied by the thread to itself before it runs anything
+	struct ThreadOptions {
+		std::string name = "rs-worker";
+		bool hasCPUs = false;
+		cpu_set_t cpus;
+		sol::optional<int> nice;
+	};
+
+	std::shared_ptr<Channel> channel;
+	std::thread thread;
+
+	// Previous getStats() call, for message rates
+	std::chrono::steady_clock::time_point lastStatsTime;
+	uint64_t lastNumSent = 0;
+	uint64_t lastNumReceived = 0;
+
+	static ThreadOptions parseOptions(sol::table options);
+	static void applyOptions(const ThreadOptions& options);
+	static void runThread(std::shared_ptr<Channel> channel, std::string fileName,
+	                      ThreadOptions options, std::promise<void> started);
+	static void interruptHook(lua_State* L, lua_Debug* ar);
 
  public:
 	Worker(std::string fileName);
+	// Options: name (up to 15 characters), cpus (list of CPU indices), nice
+	Worker(std::string fileName, sol::table options);
 	~Worker();
+	// Interrupts the script without waiting for it, which happens on collection
 	void stop();
-	void sendMessage(std::string message);
+	// Returns false if the worker's queue is full or it has stopped
+	bool sendMessage(std::string message);
 	sol::object receiveMessage(sol::this_state s);
+	// Serialized values share the queues with messages, moved in without copying
+	bool sendValue(sol::object value);
+	sol::object receiveValue(sol::this_state s);
+	sol::table getStats(sol::this_state s);
 };
\ No newline at end of file
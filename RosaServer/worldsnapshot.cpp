@@ -0,0 +1,201 @@
+#include "worldsnapshot.h"
+#include "engine.h"
+
+#include <cstring>
+
+namespace WorldSnapshot {
+// Enough that readers holding on for a tick or two never stop publishing
+static constexpr int numBuffers = 4;
+
+static Snapshot buffers[numBuffers];
+static std::atomic<Snapshot*> current(nullptr);
+static std::atomic_bool wanted(false);
+static uint64_t numTicksPublished = 0;
+
+static Snapshot* findFreeBuffer() {
+	Snapshot* published = current.load();
+	for (auto& buffer : buffers)
+		if (&buffer != published && !buffer.refCount.load()) return &buffer;
+	return nullptr;
+}
+
+void publish() {
+	numTicksPublished++;
+	if (!wanted.load(std::memory_order_relaxed)) return;
+
+	// Everything is held by readers, try again next tick
+	Snapshot* snapshot = findFreeBuffer();
+	if (!snapshot) return;
+
+	snapshot->tick = numTicksPublished;
+	snapshot->gameState = *Engine::gameState;
+
+	snapshot->numPlayers = 0;
+	for (int i = 0; i < maxNumberOfPlayers; i++) {
+		const Player* ply = &Engine::players[i];
+		if (!ply->active) continue;
+
+		PlayerEntry& entry = snapshot->players[snapshot->numPlayers++];
+		entry.index = i;
+		std::memcpy(entry.name, ply->name, sizeof(entry.name));
+		entry.name[sizeof(entry.name) - 1] = '\0';
+		entry.team = ply->team;
+		entry.money = ply->money;
+		entry.humanID = ply->humanID;
+		entry.isBot = ply->isBot;
+	}
+
+	snapshot->numHumans = 0;
+	for (int i = 0; i < maxNumberOfHumans; i++) {
+		const Human* man = &Engine::humans[i];
+		if (!man->active) continue;
+
+		HumanEntry& entry = snapshot->humans[snapshot->numHumans++];
+		entry.index = i;
+		entry.playerID = man->playerID;
+		entry.vehicleID = man->vehicleID;
+		entry.health = man->health;
+		entry.pos = man->pos;
+		entry.viewYaw = man->viewYaw;
+		entry.viewPitch = man->viewPitch;
+	}
+
+	snapshot->numItems = 0;
+	for (int i = 0; i < maxNumberOfItems; i++) {
+		const Item* item = &Engine::items[i];
+		if (!item->active) continue;
+
+		ItemEntry& entry = snapshot->items[snapshot->numItems++];
+		entry.index = i;
+		entry.type = item->type;
+		entry.parentHumanID = item->parentHumanID;
+		entry.pos = item->pos;
+		entry.vel = item->vel;
+	}
+
+	snapshot->numVehicles = 0;
+	for (int i = 0; i < maxNumberOfVehicles; i++) {
+		const Vehicle* vcl = &Engine::vehicles[i];
+		if (!vcl->active) continue;
+
+		VehicleEntry& entry = snapshot->vehicles[snapshot->numVehicles++];
+		entry.index = i;
+		entry.type = vcl->type;
+		entry.health = vcl->health;
+		entry.pos = vcl->pos;
+		entry.vel = vcl->vel;
+		entry.rot = vcl->rot;
+	}
+
+	// Sequentially consistent, like acquire's refCount increment and reload of
+	// current, so either the next findFreeBuffer sees the reader's reference or
+	// the reader sees that its snapshot stopped being current
+	current.store(snapshot);
+}
+
+std::unique_ptr<Handle> acquire() {
+	wanted = true;
+
+	while (true) {
+		Snapshot* snapshot = current.load();
+		if (!snapshot) return nullptr;
+
+		snapshot->refCount.fetch_add(1);
+		// It can only have been reused for newer data once it stopped being
+		// current, so if it still is, it's safe to read until released
+		if (current.load() == snapshot) return std::make_unique<Handle>(snapshot);
+		snapshot->refCount.fetch_sub(1);
+	}
+}
+
+const Snapshot* Handle::get() const {
+	if (!snapshot) throw std::runtime_error("Snapshot has been released");
+	return snapshot;
+}
+
+void Handle::release() {
+	if (!snapshot) return;
+	snapshot->refCount.fetch_sub(1, std::memory_order_release);
+	snapshot = nullptr;
+}
+
+uint64_t Handle::getTick() const { return get()->tick; }
+
+int Handle::getGameState() const { return get()->gameState; }
+
+sol::table Handle::getPlayers(sol::this_state s) const {
+	sol::state_view lua(s);
+	const Snapshot* snap = get();
+
+	sol::table arr = lua.create_table(snap->numPlayers);
+	for (unsigned int i = 0; i < snap->numPlayers; i++) {
+		const PlayerEntry& entry = snap->players[i];
+		sol::table t = lua.create_table(0, 6);
+		t["index"] = entry.index;
+		t["name"] = entry.name;
+		t["team"] = entry.team;
+		t["money"] = entry.money;
+		t["humanID"] = entry.humanID;
+		t["isBot"] = entry.isBot;
+		arr[i + 1] = t;
+	}
+	return arr;
+}
+
+sol::table Handle::getHumans(sol::this_state s) const {
+	sol::state_view lua(s);
+	const Snapshot* snap = get();
+
+	sol::table arr = lua.create_table(snap->numHumans);
+	for (unsigned int i = 0; i < snap->numHumans; i++) {
+		const HumanEntry& entry = snap->humans[i];
+		sol::table t = lua.create_table(0, 7);
+		t["index"] = entry.index;
+		t["playerID"] = entry.playerID;
+		t["vehicleID"] = entry.vehicleID;
+		t["health"] = entry.health;
+		t["pos"] = entry.pos;
+		t["viewYaw"] = entry.viewYaw;
+		t["viewPitch"] = entry.viewPitch;
+		arr[i + 1] = t;
+	}
+	return arr;
+}
+
+sol::table Handle::getItems(sol::this_state s) const {
+	sol::state_view lua(s);
+	const Snapshot* snap = get();
+
+	sol::table arr = lua.create_table(snap->numItems);
+	for (unsigned int i = 0; i < snap->numItems; i++) {
+		const ItemEntry& entry = snap->items[i];
+		sol::table t = lua.create_table(0, 5);
+		t["index"] = entry.index;
+		t["type"] = entry.type;
+		t["parentHumanID"] = entry.parentHumanID;
+		t["pos"] = entry.pos;
+		t["vel"] = entry.vel;
+		arr[i + 1] = t;
+	}
+	return arr;
+}
+
+sol::table Handle::getVehicles(sol::this_state s) const {
+	sol::state_view lua(s);
+	const Snapshot* snap = get();
+
+	sol::table arr = lua.create_table(snap->numVehicles);
+	for (unsigned int i = 0; i < snap->numVehicles; i++) {
+		const VehicleEntry& entry = snap->vehicles[i];
+		sol::table t = lua.create_table(0, 6);
+		t["index"] = entry.index;
+		t["type"] = entry.type;
+		t["health"] = entry.health;
+		t["pos"] = entry.pos;
+		t["vel"] = entry.vel;
+		t["rot"] = entry.rot;
+		arr[i + 1] = t;
+	}
+	return arr;
+}
+}  // namespace WorldSnapshot
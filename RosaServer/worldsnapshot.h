@@ -0,0 +1,86 @@
+#pragma once
+#include "sol/sol.hpp"
+#include "structs.h"
+
+#include <atomic>
+
+// Read-only copies of hot entity fields, published by the tick thread after
+// physics and readable from any thread without locking it.
+namespace WorldSnapshot {
+struct PlayerEntry {
+	int index;
+	char name[32];
+	unsigned int team;
+	int money;
+	int humanID;
+	bool isBot;
+};
+
+struct HumanEntry {
+	int index;
+	int playerID;
+	int vehicleID;
+	int health;
+	Vector pos;
+	float viewYaw;
+	float viewPitch;
+};
+
+struct ItemEntry {
+	int index;
+	int type;
+	int parentHumanID;
+	Vector pos;
+	Vector vel;
+};
+
+struct VehicleEntry {
+	int index;
+	unsigned int type;
+	int health;
+	Vector pos;
+	Vector vel;
+	RotMatrix rot;
+};
+
+struct Snapshot {
+	std::atomic_uint refCount{0};
+
+	uint64_t tick;
+	int gameState;
+	unsigned int numPlayers;
+	unsigned int numHumans;
+	unsigned int numItems;
+	unsigned int numVehicles;
+	PlayerEntry players[maxNumberOfPlayers];
+	HumanEntry humans[maxNumberOfHumans];
+	ItemEntry items[maxNumberOfItems];
+	VehicleEntry vehicles[maxNumberOfVehicles];
+};
+
+// Holds a snapshot for as long as it lives, or until released
+class Handle {
+	Snapshot* snapshot;
+
+	const Snapshot* get() const;
+
+ public:
+	Handle(Snapshot* snapshot) : snapshot(snapshot) {}
+	Handle(const Handle&) = delete;
+	Handle& operator=(const Handle&) = delete;
+	~Handle() { release(); }
+
+	void release();
+	uint64_t getTick() const;
+	int getGameState() const;
+	sol::table getPlayers(sol::this_state s) const;
+	sol::table getHumans(sol::this_state s) const;
+	sol::table getItems(sol::this_state s) const;
+	sol::table getVehicles(sol::this_state s) const;
+};
+
+// Tick thread only. Does nothing until something has asked for a snapshot.
+void publish();
+// Returns nullptr if nothing has been published yet
+std::unique_ptr<Handle> acquire();
+}  // namespace WorldSnapshot
@@ -0,0 +1,234 @@
+#include "eventloop.h"
+#include "transport.h"
+
+#include <sys/epoll.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace EventLoop {
+using Clock = std::chrono::steady_clock;
+
+static constexpr int maxEvents = 64;
+
+struct Timer {
+	Clock::time_point due;
+	unsigned int intervalMs;
+	TimerCallback callback;
+};
+
+static int epollFD = -1;
+static int serverFD = -1;
+static bool serverGone = false;
+static bool stopping = false;
+
+static uint64_t nextTimerID = 1;
+static std::unordered_map<uint64_t, Timer> timers;
+// Ordered by when they're due
+static std::set<std::pair<Clock::time_point, uint64_t>> timerQueue;
+
+static std::unordered_map<int, FDCallback> watched;
+static MessageHandler messageHandler;
+
+void init() {
+	epollFD = epoll_create1(EPOLL_CLOEXEC);
+	if (epollFD == -1) throw std::runtime_error(strerror(errno));
+
+	serverFD = Transport::getServerFD();
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = serverFD;
+	if (epoll_ctl(epollFD, EPOLL_CTL_ADD, serverFD, &event) == -1)
+		throw std::runtime_error(strerror(errno));
+}
+
+void reset() {
+	timers.clear();
+	timerQueue.clear();
+
+	for (auto& [fd, callback] : watched)
+		epoll_ctl(epollFD, EPOLL_CTL_DEL, fd, nullptr);
+	watched.clear();
+
+	messageHandler = nullptr;
+	stopping = false;
+}
+
+uint64_t addTimer(unsigned int delayMs, unsigned int intervalMs,
+                  TimerCallback callback) {
+	uint64_t id = nextTimerID++;
+	auto due = Clock::now() + std::chrono::milliseconds(delayMs);
+
+	timers[id] = {due, intervalMs, std::move(callback)};
+	timerQueue.emplace(due, id);
+	return id;
+}
+
+bool removeTimer(uint64_t id) {
+	auto it = timers.find(id);
+	if (it == timers.end()) return false;
+
+	timerQueue.erase({it->second.due, id});
+	timers.erase(it);
+	return true;
+}
+
+void watch(int fd, uint32_t events, FDCallback callback) {
+	if (fd == serverFD)
+		throw std::invalid_argument("Can't watch the server's pipe");
+
+	epoll_event event{};
+	event.events = events;
+	event.data.fd = fd;
+
+	int operation = watched.count(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	if (epoll_ctl(epollFD, operation, fd, &event) == -1)
+		throw std::runtime_error(strerror(errno));
+
+	watched[fd] = std::move(callback);
+}
+
+void unwatch(int fd) {
+	auto it = watched.find(fd);
+	if (it == watched.end()) return;
+
+	// Fails harmlessly if the fd was already closed
+	epoll_ctl(epollFD, EPOLL_CTL_DEL, fd, nullptr);
+	watched.erase(it);
+}
+
+static int millisecondsUntil(Clock::time_point time) {
+	auto remaining =
+	    std::chrono::ceil<std::chrono::milliseconds>(time - Clock::now());
+	return remaining.count() > 0 ? static_cast<int>(remaining.count()) : 0;
+}
+
+static void runDueTimers() {
+	// Timers added by callbacks wait for the next round, so a zero delay
+	// timer that re-adds itself can't starve everything else
+	auto now = Clock::now();
+
+	while (!timerQueue.empty() && timerQueue.begin()->first <= now) {
+		uint64_t id = timerQueue.begin()->second;
+		timerQueue.erase(timerQueue.begin());
+
+		auto it = timers.find(id);
+		// Copied, since the callback can remove its own timer
+		TimerCallback callback = it->second.callback;
+
+		if (it->second.intervalMs) {
+			auto interval = std::chrono::milliseconds(it->second.intervalMs);
+			// Keeps to schedule, but skips ticks rather than catching up
+			it->second.due += interval;
+			if (it->second.due <= now) it->second.due = now + interval;
+			timerQueue.emplace(it->second.due, id);
+		} else {
+			timers.erase(it);
+		}
+
+		callback();
+	}
+}
+
+// Waits for at most timeoutMs (forever if negative), then runs whatever is
+// ready. Only wakes for new messages if asked to.
+static void step(int timeoutMs, bool wakeOnMessage) {
+	int wait = timeoutMs;
+	if (!timerQueue.empty()) {
+		int untilTimer = millisecondsUntil(timerQueue.begin()->first);
+		if (wait < 0 || untilTimer < wait) wait = untilTimer;
+	}
+
+	if (wakeOnMessage) {
+		Transport::beginWait();
+		if (Transport::hasMessage()) wait = 0;
+	}
+
+	epoll_event events[maxEvents];
+	int count = epoll_wait(epollFD, events, maxEvents, wait);
+	int savedErrno = errno;
+
+	if (wakeOnMessage) Transport::endWait();
+
+	if (count == -1) {
+		if (savedErrno != EINTR) throw std::runtime_error(strerror(savedErrno));
+		count = 0;
+	}
+
+	for (int i = 0; i < count; i++) {
+		int fd = events[i].data.fd;
+
+		if (fd == serverFD) {
+			// Anything already sent stays readable after the server is gone
+			bool open = Transport::pollServer();
+			if (!open || (events[i].events & (EPOLLHUP | EPOLLERR))) {
+				epoll_ctl(epollFD, EPOLL_CTL_DEL, serverFD, nullptr);
+				serverGone = true;
+			}
+			continue;
+		}
+
+		// An earlier callback in this batch may have unwatched it
+		auto it = watched.find(fd);
+		if (it == watched.end()) continue;
+
+		FDCallback callback = it->second;
+		callback(events[i].events);
+	}
+
+	runDueTimers();
+}
+
+bool waitMessage(std::string& message, int timeoutMs) {
+	auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+
+	while (true) {
+		if (Transport::readMessage(message)) return true;
+		if (serverGone) return false;
+
+		int remaining = -1;
+		if (timeoutMs >= 0) {
+			remaining = millisecondsUntil(deadline);
+			if (!remaining) return false;
+		}
+
+		step(remaining, true);
+	}
+}
+
+void sleep(unsigned int ms) {
+	auto deadline = Clock::now() + std::chrono::milliseconds(ms);
+
+	while (int remaining = millisecondsUntil(deadline)) step(remaining, false);
+}
+
+void setMessageHandler(MessageHandler handler) {
+	messageHandler = std::move(handler);
+}
+
+void run() {
+	while (!stopping) {
+		if (messageHandler) {
+			std::string message;
+			while (!stopping && messageHandler && Transport::readMessage(message)) {
+				// Copied, since the handler can replace itself
+				MessageHandler handler = messageHandler;
+				handler(message);
+			}
+			if (stopping) break;
+		}
+
+		bool waitForMessages = messageHandler && !serverGone;
+		if (!waitForMessages && timers.empty() && watched.empty()) break;
+
+		step(-1, waitForMessages);
+	}
+
+	stopping = false;
+}
+
+void stop() { stopping = true; }
+}  // namespace EventLoop
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Everything a satellite waits on, in one epoll set: messages from the server,
+// timers and file descriptors scripts watch. Waiting uses no CPU.
+namespace EventLoop {
+using TimerCallback = std::function<void()>;
+// Gets the epoll events that fired
+using FDCallback = std::function<void(uint32_t)>;
+using MessageHandler = std::function<void(const std::string&)>;
+
+void init();
+// Drops every timer, watched fd and handler, before the state they belong to
+// goes away
+void reset();
+
+// An interval of 0 fires once
+uint64_t addTimer(unsigned int delayMs, unsigned int intervalMs,
+                  TimerCallback callback);
+bool removeTimer(uint64_t id);
+
+// Watching an fd that's already watched replaces its events and callback
+void watch(int fd, uint32_t events, FDCallback callback);
+void unwatch(int fd);
+
+// Returns false on timeout or once the server is gone. A negative timeout
+// waits forever.
+bool waitMessage(std::string& message, int timeoutMs);
+// Runs timers and fd callbacks until the time is up
+void sleep(unsigned int ms);
+
+void setMessageHandler(MessageHandler handler);
+// Runs until stop() is called or there's nothing left to wait for
+void run();
+void stop();
+}  // namespace EventLoop
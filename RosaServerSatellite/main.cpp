@@ -1,19 +1,19 @@
+#include "eventloop.h"
+#include "framing.h"
+#include "serialize.h"
+#include "socket.h"
 #include "sol/sol.hpp"
+#include "transport.h"
 
-#include <unistd.h>
+#include <sys/epoll.h>
 #include <chrono>
-#include <thread>
+#include <cstring>
+#include <memory>
 
 static constexpr int CODE_INVALID_USAGE = 1;
 static constexpr int CODE_FILE_INVALID = 2;
 static constexpr int CODE_FILE_RUNTIME_ERROR = 3;
 
-static constexpr const char* ERR_WRITING_MESSAGE =
-    "Couldn't write full message to pipe";
-
-static int fdFromParent;
-static int fdToParent;
-
 static double l_os_realClock() {
 	auto now = std::chrono::steady_clock::now();
 	auto ms = std::chrono::time_point_cast<std::chrono::milliseconds>(now);
@@ -25,85 +25,277 @@ static double l_os_realClock() {
 static sol::object l_receiveMessage(sol::this_state s) {
 	sol::state_view lua(s);
 
-	unsigned int length;
-
-	auto bytesRead = read(fdFromParent, &length, sizeof(length));
-	if (bytesRead == -1) {
-		if (errno != EAGAIN) {
-			throw std::runtime_error(strerror(errno));
-		}
-	} else if (bytesRead == sizeof(length)) {
-		std::string message(length, ' ');
-		bytesRead = read(fdFromParent, message.data(), length);
-		if (bytesRead == -1) {
-			if (errno != EAGAIN) {
-				throw std::runtime_error(strerror(errno));
-			}
-		} else if (bytesRead == length) {
-			return sol::make_object(lua, message);
-		}
+	std::string message;
+	if (Transport::readMessage(message)) {
+		return sol::make_object(lua, message);
 	}
 
 	return sol::make_object(lua, sol::lua_nil);
 }
 
+static sol::table l_receiveMessages(sol::this_state s) {
+	sol::state_view lua(s);
+	sol::table messages = lua.create_table();
+
+	Transport::pollServer();
+
+	std::string message;
+	int count = 0;
+	while (Transport::nextBufferedMessage(message)) messages[++count] = message;
+
+	return messages;
+}
+
 static void l_sendMessage(std::string message) {
-	unsigned int length = static_cast<unsigned int>(message.length());
-
-	auto bytesWritten = write(fdToParent, &length, sizeof(length));
-	if (bytesWritten == -1) {
-		throw std::runtime_error(strerror(errno));
-	} else if (bytesWritten != sizeof(length)) {
-		throw std::runtime_error(ERR_WRITING_MESSAGE);
-	} else {
-		bytesWritten = write(fdToParent, message.data(), length);
-		if (bytesWritten == -1) {
-			throw std::runtime_error(strerror(errno));
-		} else if (bytesWritten != length) {
-			throw std::runtime_error(ERR_WRITING_MESSAGE);
+	Transport::writeMessage(message);
+}
+
+// Vectors and RotMatrices don't exist here, so values holding them can't be
+// received
+static sol::object l_receiveValue(sol::this_state s) {
+	std::string encoded;
+	if (Transport::readMessage(encoded)) {
+		return Serialize::decode(s, encoded);
+	}
+
+	return sol::make_object(s, sol::lua_nil);
+}
+
+static void l_sendValue(sol::object value) {
+	Transport::writeMessage(Serialize::encode(value));
+}
+
+static sol::object l_waitMessage(sol::optional<int> timeoutMs,
+                                 sol::this_state s) {
+	std::string message;
+	if (EventLoop::waitMessage(message, timeoutMs.value_or(-1))) {
+		return sol::make_object(s, message);
+	}
+
+	return sol::make_object(s, sol::lua_nil);
+}
+
+static sol::object l_waitValue(sol::optional<int> timeoutMs,
+                               sol::this_state s) {
+	std::string encoded;
+	if (EventLoop::waitMessage(encoded, timeoutMs.value_or(-1))) {
+		return Serialize::decode(s, encoded);
+	}
+
+	return sol::make_object(s, sol::lua_nil);
+}
+
+// Errors in callbacks come out of whatever was waiting
+template <typename... Args>
+static void callOrThrow(const sol::protected_function& function,
+                        Args&&... args) {
+	sol::protected_function_result res =
+	    function(std::forward<Args>(args)...);
+	if (!res.valid()) {
+		sol::error err = res;
+		throw std::runtime_error(err.what());
+	}
+}
+
+static uint64_t l_setTimeout(sol::protected_function callback,
+                             unsigned int ms) {
+	return EventLoop::addTimer(ms, 0, [callback]() { callOrThrow(callback); });
+}
+
+static uint64_t l_setInterval(sol::protected_function callback,
+                              unsigned int ms) {
+	// A zero interval would never let anything else run
+	if (!ms) ms = 1;
+	return EventLoop::addTimer(ms, ms, [callback]() { callOrThrow(callback); });
+}
+
+// Events is any combination of "r" and "w"
+static uint32_t parseEvents(const std::string& events) {
+	uint32_t epollEvents = 0;
+	for (char event : events) {
+		if (event == 'r')
+			epollEvents |= EPOLLIN;
+		else if (event == 'w')
+			epollEvents |= EPOLLOUT;
+		else
+			throw std::invalid_argument("Events must be made of 'r' and 'w'");
+	}
+	return epollEvents;
+}
+
+// The callback gets the fd, then whether it's readable, writable, and hung up
+static void l_watchFD(int fd, const std::string& events,
+                      sol::protected_function callback) {
+	EventLoop::watch(fd, parseEvents(events), [fd, callback](uint32_t fired) {
+		callOrThrow(callback, fd, (fired & EPOLLIN) != 0, (fired & EPOLLOUT) != 0,
+		            (fired & (EPOLLHUP | EPOLLERR)) != 0);
+	});
+}
+
+// Like watchFD, without the fd
+static void l_socket_watch(Socket* socket, const std::string& events,
+                           sol::protected_function callback) {
+	socket->watch(parseEvents(events), [callback](uint32_t fired) {
+		callOrThrow(callback, (fired & EPOLLIN) != 0, (fired & EPOLLOUT) != 0,
+		            (fired & (EPOLLHUP | EPOLLERR)) != 0);
+	});
+}
+
+static void l_setMessageHandler(
+    sol::optional<sol::protected_function> handler) {
+	if (!handler) {
+		EventLoop::setMessageHandler(nullptr);
+		return;
+	}
+
+	EventLoop::setMessageHandler(
+	    [callback = *handler](const std::string& message) {
+		    callOrThrow(callback, message);
+	    });
+}
+
+static std::string l_serialize_encode(sol::object value) {
+	return Serialize::encode(value);
+}
+
+static sol::object l_serialize_decode(const std::string& data,
+                                      sol::this_state s) {
+	return Serialize::decode(s, data);
+}
+
+static std::unique_ptr<sol::state> createState() {
+	auto lua = std::make_unique<sol::state>();
+	lua->open_libraries(sol::lib::base);
+	lua->open_libraries(sol::lib::package);
+	lua->open_libraries(sol::lib::coroutine);
+	lua->open_libraries(sol::lib::string);
+	lua->open_libraries(sol::lib::os);
+	lua->open_libraries(sol::lib::math);
+	lua->open_libraries(sol::lib::table);
+	lua->open_libraries(sol::lib::debug);
+	lua->open_libraries(sol::lib::bit32);
+	lua->open_libraries(sol::lib::io);
+	lua->open_libraries(sol::lib::ffi);
+	lua->open_libraries(sol::lib::jit);
+
+	(*lua)["os"]["realClock"] = l_os_realClock;
+
+	(*lua)["receiveMessage"] = l_receiveMessage;
+	(*lua)["receiveMessages"] = l_receiveMessages;
+	(*lua)["sendMessage"] = l_sendMessage;
+	(*lua)["receiveValue"] = l_receiveValue;
+	(*lua)["sendValue"] = l_sendValue;
+
+	(*lua)["serialize"] = lua->create_table();
+	(*lua)["serialize"]["encode"] = l_serialize_encode;
+	(*lua)["serialize"]["decode"] = l_serialize_decode;
+
+	(*lua)["waitMessage"] = l_waitMessage;
+	(*lua)["waitValue"] = l_waitValue;
+	(*lua)["setTimeout"] = l_setTimeout;
+	(*lua)["setInterval"] = l_setInterval;
+	(*lua)["clearTimer"] = EventLoop::removeTimer;
+	(*lua)["watchFD"] = l_watchFD;
+	(*lua)["unwatchFD"] = EventLoop::unwatch;
+	(*lua)["setMessageHandler"] = l_setMessageHandler;
+	(*lua)["runEventLoop"] = EventLoop::run;
+	(*lua)["stopEventLoop"] = EventLoop::stop;
+	// Timers and watched fds keep running while sleeping
+	(*lua)["sleep"] = EventLoop::sleep;
+
+	{
+		auto meta = lua->new_usertype<Socket>("Socket", sol::no_constructor);
+		meta["listenTCP"] = &Socket::listenTCP;
+		meta["connectTCP"] = &Socket::connectTCP;
+		meta["openUDP"] = &Socket::openUDP;
+		meta["listenUnix"] = &Socket::listenUnix;
+		meta["connectUnix"] = &Socket::connectUnix;
+
+		meta["fd"] = sol::property(&Socket::getFD);
+		meta["isOpen"] = sol::property(&Socket::isOpen);
+		meta["isListening"] = sol::property(&Socket::isListening);
+		meta["accept"] = &Socket::accept;
+		meta["isConnected"] = &Socket::isConnected;
+		meta["send"] = &Socket::send;
+		meta["receive"] = &Socket::receive;
+		meta["sendTo"] = &Socket::sendTo;
+		meta["receiveFrom"] = &Socket::receiveFrom;
+		meta["getLocalAddress"] = &Socket::getLocalAddress;
+		meta["getPeerAddress"] = &Socket::getPeerAddress;
+		meta["watch"] = l_socket_watch;
+		meta["unwatch"] = &Socket::unwatch;
+		meta["close"] = &Socket::close;
+	}
+
+	return lua;
+}
+
+static int run(sol::load_result& load) {
+	if (!load.valid()) return CODE_FILE_INVALID;
+
+	sol::protected_function_result res = load();
+	// Callbacks hold references into the state, which is about to go
+	EventLoop::reset();
+	if (!res.valid()) return CODE_FILE_RUNTIME_ERROR;
+
+	return 0;
+}
+
+// Pooled satellites stay alive between jobs, each in a fresh state that's set
+// up while waiting for the job
+static int runPool() {
+	auto lua = createState();
+
+	while (true) {
+		std::string frame;
+		bool isControl;
+		if (!Transport::readFrame(frame, isControl)) {
+			if (!Transport::pollServer()) return 0;
+			Transport::waitForFrame();
+			continue;
 		}
+
+		// Anything left over for the previous job is dropped
+		if (!isControl || frame.empty()) continue;
+
+		std::string source = frame.substr(1);
+		int status;
+		if (frame[0] == Framing::controlRunFile) {
+			sol::load_result load = lua->load_file(source);
+			status = run(load);
+		} else if (frame[0] == Framing::controlRunChunk) {
+			sol::load_result load = lua->load(source);
+			status = run(load);
+		} else {
+			continue;
+		}
+
+		lua.reset();
+
+		std::string done{Framing::controlJobDone, static_cast<char>(status)};
+		Transport::writeControl(done);
+
+		lua = createState();
 	}
 }
 
 int main(int argc, const char* argv[]) {
 	if (argc < 4) return CODE_INVALID_USAGE;
 
-	fdFromParent = atoi(argv[1]);
-	fdToParent = atoi(argv[2]);
 	const char* fileName = argv[3];
+	int sharedFD = argc >= 5 ? atoi(argv[4]) : -1;
+	if (!Transport::init(atoi(argv[1]), atoi(argv[2]), sharedFD))
+		return CODE_INVALID_USAGE;
 
-	sol::state lua;
-	lua.open_libraries(sol::lib::base);
-	lua.open_libraries(sol::lib::package);
-	lua.open_libraries(sol::lib::coroutine);
-	lua.open_libraries(sol::lib::string);
-	lua.open_libraries(sol::lib::os);
-	lua.open_libraries(sol::lib::math);
-	lua.open_libraries(sol::lib::table);
-	lua.open_libraries(sol::lib::debug);
-	lua.open_libraries(sol::lib::bit32);
-	lua.open_libraries(sol::lib::io);
-	lua.open_libraries(sol::lib::ffi);
-	lua.open_libraries(sol::lib::jit);
-
-	lua["os"]["realClock"] = l_os_realClock;
-
-	lua["receiveMessage"] = l_receiveMessage;
-	lua["sendMessage"] = l_sendMessage;
-
-	lua["sleep"] = [](unsigned int ms) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
-	};
-
-	sol::load_result load = lua.load_file(fileName);
-	if (load.valid()) {
-		sol::protected_function_result res = load();
-		if (!res.valid()) {
-			return CODE_FILE_RUNTIME_ERROR;
-		}
-	} else {
-		return CODE_FILE_INVALID;
+	try {
+		EventLoop::init();
+	} catch (const std::exception&) {
+		return CODE_INVALID_USAGE;
 	}
 
-	return 0;
+	if (!strcmp(fileName, "--pool")) return runPool();
+
+	auto lua = createState();
+	sol::load_result load = lua->load_file(fileName);
+	return run(load);
 }
\ No newline at end of file
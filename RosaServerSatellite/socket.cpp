@@ -0,0 +1,343 @@
+#include "socket.h"
+#include "eventloop.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr size_t defaultReceiveSize = 64 * 1024;
+
+[[noreturn]] static void throwErrno() {
+	throw std::runtime_error(strerror(errno));
+}
+
+static void checkPort(int port) {
+	if (port < 0 || port > 65535)
+		throw std::invalid_argument("Port out of range");
+}
+
+static socklen_t toAddress(const std::string& host, int port,
+                           sockaddr_storage& address) {
+	checkPort(port);
+	std::memset(&address, 0, sizeof(address));
+
+	auto ipv4 = reinterpret_cast<sockaddr_in*>(&address);
+	if (inet_pton(AF_INET, host.c_str(), &ipv4->sin_addr) == 1) {
+		ipv4->sin_family = AF_INET;
+		ipv4->sin_port = htons(port);
+		return sizeof(sockaddr_in);
+	}
+
+	auto ipv6 = reinterpret_cast<sockaddr_in6*>(&address);
+	if (inet_pton(AF_INET6, host.c_str(), &ipv6->sin6_addr) == 1) {
+		ipv6->sin6_family = AF_INET6;
+		ipv6->sin6_port = htons(port);
+		return sizeof(sockaddr_in6);
+	}
+
+	throw std::invalid_argument("Host must be a numeric IPv4 or IPv6 address");
+}
+
+static socklen_t toUnixAddress(const std::string& path,
+                               sockaddr_storage& address) {
+	auto unixAddress = reinterpret_cast<sockaddr_un*>(&address);
+	if (path.empty() || path.length() >= sizeof(unixAddress->sun_path))
+		throw std::invalid_argument("Invalid socket path length");
+
+	std::memset(&address, 0, sizeof(address));
+	unixAddress->sun_family = AF_UNIX;
+	std::memcpy(unixAddress->sun_path, path.c_str(), path.length());
+	return sizeof(sockaddr_un);
+}
+
+// Unix sockets give their path and port 0
+static std::tuple<std::string, int> fromAddress(
+    const sockaddr_storage& address) {
+	char host[INET6_ADDRSTRLEN] = "";
+
+	switch (address.ss_family) {
+		case AF_INET: {
+			auto ipv4 = reinterpret_cast<const sockaddr_in*>(&address);
+			inet_ntop(AF_INET, &ipv4->sin_addr, host, sizeof(host));
+			return {host, ntohs(ipv4->sin_port)};
+		}
+		case AF_INET6: {
+			auto ipv6 = reinterpret_cast<const sockaddr_in6*>(&address);
+			inet_ntop(AF_INET6, &ipv6->sin6_addr, host, sizeof(host));
+			return {host, ntohs(ipv6->sin6_port)};
+		}
+		case AF_UNIX:
+			return {reinterpret_cast<const sockaddr_un*>(&address)->sun_path, 0};
+		default:
+			return {"", 0};
+	}
+}
+
+static int createSocket(int family, int type) {
+	int fd = socket(family, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd == -1) throwErrno();
+	return fd;
+}
+
+std::unique_ptr<Socket> Socket::listenTCP(const std::string& host, int port,
+                                          sol::optional<int> backlog) {
+	sockaddr_storage address;
+	socklen_t length = toAddress(host, port, address);
+
+	std::unique_ptr<Socket> socket(
+	    new Socket(createSocket(address.ss_family, SOCK_STREAM), SOCK_STREAM));
+
+	// Restarted scripts can listen again without waiting out TIME_WAIT
+	int enable = 1;
+	setsockopt(socket->fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+	if (bind(socket->fd, reinterpret_cast<sockaddr*>(&address), length) == -1)
+		throwErrno();
+	if (listen(socket->fd, backlog.value_or(SOMAXCONN)) == -1) throwErrno();
+
+	socket->listening = true;
+	return socket;
+}
+
+std::unique_ptr<Socket> Socket::connectTCP(const std::string& host, int port) {
+	sockaddr_storage address;
+	socklen_t length = toAddress(host, port, address);
+
+	std::unique_ptr<Socket> socket(
+	    new Socket(createSocket(address.ss_family, SOCK_STREAM), SOCK_STREAM));
+
+	if (connect(socket->fd, reinterpret_cast<sockaddr*>(&address), length) ==
+	        -1 &&
+	    errno != EINPROGRESS)
+		throwErrno();
+
+	return socket;
+}
+
+std::unique_ptr<Socket> Socket::openUDP(const std::string& host, int port) {
+	sockaddr_storage address;
+	socklen_t length = toAddress(host, port, address);
+
+	std::unique_ptr<Socket> socket(
+	    new Socket(createSocket(address.ss_family, SOCK_DGRAM), SOCK_DGRAM));
+
+	if (bind(socket->fd, reinterpret_cast<sockaddr*>(&address), length) == -1)
+		throwErrno();
+
+	return socket;
+}
+
+std::unique_ptr<Socket> Socket::listenUnix(const std::string& path,
+                                           sol::optional<int> backlog) {
+	sockaddr_storage address;
+	socklen_t length = toUnixAddress(path, address);
+
+	std::unique_ptr<Socket> socket(
+	    new Socket(createSocket(AF_UNIX, SOCK_STREAM), SOCK_STREAM));
+
+	// Left behind by a satellite that didn't get to close it, but never
+	// remove anything that isn't a socket
+	struct stat info;
+	if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+		unlink(path.c_str());
+
+	if (bind(socket->fd, reinterpret_cast<sockaddr*>(&address), length) == -1)
+		throwErrno();
+	socket->unixPath = path;
+
+	if (listen(socket->fd, backlog.value_or(SOMAXCONN)) == -1) throwErrno();
+
+	socket->listening = true;
+	return socket;
+}
+
+std::unique_ptr<Socket> Socket::connectUnix(const std::string& path) {
+	sockaddr_storage address;
+	socklen_t length = toUnixAddress(path, address);
+
+	std::unique_ptr<Socket> socket(
+	    new Socket(createSocket(AF_UNIX, SOCK_STREAM), SOCK_STREAM));
+
+	// Unix sockets connect immediately or not at all
+	if (connect(socket->fd, reinterpret_cast<sockaddr*>(&address), length) ==
+	    -1)
+		throwErrno();
+
+	return socket;
+}
+
+Socket::~Socket() { close(); }
+
+void Socket::checkOpen() const {
+	if (fd == -1) throw std::runtime_error("Socket is closed");
+}
+
+std::unique_ptr<Socket> Socket::accept() {
+	checkOpen();
+	if (!listening) throw std::runtime_error("Socket is not listening");
+
+	while (true) {
+		int client = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (client != -1)
+			return std::unique_ptr<Socket>(new Socket(client, type));
+
+		if (errno == EINTR) continue;
+		// The client gave up before we got to it
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED)
+			return nullptr;
+		throwErrno();
+	}
+}
+
+bool Socket::isConnected() {
+	checkOpen();
+
+	int error;
+	socklen_t length = sizeof(error);
+	if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == -1)
+		throwErrno();
+	if (error) throw std::runtime_error(strerror(error));
+
+	sockaddr_storage address;
+	length = sizeof(address);
+	if (getpeername(fd, reinterpret_cast<sockaddr*>(&address), &length) == 0)
+		return true;
+	if (errno == ENOTCONN) return false;
+	throwErrno();
+}
+
+size_t Socket::send(const std::string& data) {
+	checkOpen();
+
+	while (true) {
+		// A closed peer is an error here rather than a SIGPIPE
+		auto bytesSent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+		if (bytesSent != -1) return bytesSent;
+
+		if (errno == EINTR) continue;
+		if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+		throwErrno();
+	}
+}
+
+sol::object Socket::receive(sol::optional<size_t> maxBytes,
+                            sol::this_state s) {
+	checkOpen();
+
+	std::string data(maxBytes.value_or(defaultReceiveSize), '\0');
+	while (true) {
+		auto bytesRead = recv(fd, &data[0], data.size(), 0);
+		if (bytesRead != -1) {
+			data.resize(bytesRead);
+			return sol::make_object(s, data);
+		}
+
+		if (errno == EINTR) continue;
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return sol::make_object(s, sol::lua_nil);
+		// Reset streams are as closed as cleanly shut down ones
+		if (errno == ECONNRESET) return sol::make_object(s, std::string());
+		throwErrno();
+	}
+}
+
+bool Socket::sendTo(const std::string& data, const std::string& host,
+                    int port) {
+	checkOpen();
+	if (type != SOCK_DGRAM)
+		throw std::runtime_error("Only UDP sockets can send to an address");
+
+	sockaddr_storage address;
+	socklen_t length = toAddress(host, port, address);
+
+	while (true) {
+		auto bytesSent = sendto(fd, data.data(), data.size(), 0,
+		                        reinterpret_cast<sockaddr*>(&address), length);
+		if (bytesSent != -1) return true;
+
+		if (errno == EINTR) continue;
+		if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+		throwErrno();
+	}
+}
+
+std::tuple<sol::object, sol::object, sol::object> Socket::receiveFrom(
+    sol::optional<size_t> maxBytes, sol::this_state s) {
+	checkOpen();
+	if (type != SOCK_DGRAM)
+		throw std::runtime_error("Only UDP sockets can receive from an address");
+
+	std::string data(maxBytes.value_or(defaultReceiveSize), '\0');
+	sockaddr_storage address;
+
+	while (true) {
+		socklen_t length = sizeof(address);
+		auto bytesRead = recvfrom(fd, &data[0], data.size(), 0,
+		                          reinterpret_cast<sockaddr*>(&address), &length);
+		if (bytesRead != -1) {
+			data.resize(bytesRead);
+			auto [host, port] = fromAddress(address);
+			return {sol::make_object(s, data), sol::make_object(s, host),
+			        sol::make_object(s, port)};
+		}
+
+		if (errno == EINTR) continue;
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			sol::object nil = sol::make_object(s, sol::lua_nil);
+			return {nil, nil, nil};
+		}
+		throwErrno();
+	}
+}
+
+std::tuple<std::string, int> Socket::getLocalAddress() const {
+	checkOpen();
+
+	sockaddr_storage address;
+	socklen_t length = sizeof(address);
+	if (getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) == -1)
+		throwErrno();
+	return fromAddress(address);
+}
+
+std::tuple<std::string, int> Socket::getPeerAddress() const {
+	checkOpen();
+
+	sockaddr_storage address;
+	socklen_t length = sizeof(address);
+	if (getpeername(fd, reinterpret_cast<sockaddr*>(&address), &length) == -1)
+		throwErrno();
+	return fromAddress(address);
+}
+
+void Socket::watch(uint32_t events, std::function<void(uint32_t)> callback) {
+	checkOpen();
+	EventLoop::watch(fd, events, std::move(callback));
+	watching = true;
+}
+
+void Socket::unwatch() {
+	if (!watching) return;
+	EventLoop::unwatch(fd);
+	watching = false;
+}
+
+void Socket::close() {
+	if (fd == -1) return;
+
+	// Before the fd number can be reused
+	unwatch();
+	::close(fd);
+	fd = -1;
+
+	if (!unixPath.empty()) {
+		unlink(unixPath.c_str());
+		unixPath.clear();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "sol/sol.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+
+// Non-blocking TCP, UDP and Unix stream sockets, driven by the event loop.
+// Hosts are numeric IPv4 or IPv6 addresses, since resolving names would block
+// everything else in the satellite.
+class Socket {
+	int fd;
+	int type;
+	bool listening = false;
+	bool watching = false;
+	// Listening Unix sockets remove their file when closed
+	std::string unixPath;
+
+	Socket(int fd, int type) : fd(fd), type(type) {}
+	void checkOpen() const;
+
+ public:
+	static std::unique_ptr<Socket> listenTCP(const std::string& host, int port,
+	                                         sol::optional<int> backlog);
+	// Returns straight away, the socket becomes writable once connected
+	static std::unique_ptr<Socket> connectTCP(const std::string& host, int port);
+	// Port 0 picks a free one
+	static std::unique_ptr<Socket> openUDP(const std::string& host, int port);
+	static std::unique_ptr<Socket> listenUnix(const std::string& path,
+	                                          sol::optional<int> backlog);
+	static std::unique_ptr<Socket> connectUnix(const std::string& path);
+
+	Socket(const Socket&) = delete;
+	Socket& operator=(const Socket&) = delete;
+	~Socket();
+
+	int getFD() const { return fd; }
+	bool isOpen() const { return fd != -1; }
+	bool isListening() const { return listening; }
+
+	// Returns nil if nobody is waiting to connect
+	std::unique_ptr<Socket> accept();
+	// False while a connect is in progress, throws if it failed
+	bool isConnected();
+
+	// Returns how many bytes went out, 0 if the buffer is full
+	size_t send(const std::string& data);
+	// Returns nil if nothing is available, and an empty string once the other
+	// end has closed a stream
+	sol::object receive(sol::optional<size_t> maxBytes, sol::this_state s);
+
+	// UDP only
+	bool sendTo(const std::string& data, const std::string& host, int port);
+	// Returns the datagram, host and port, or nil if nothing is available
+	std::tuple<sol::object, sol::object, sol::object> receiveFrom(
+	    sol::optional<size_t> maxBytes, sol::this_state s);
+
+	std::tuple<std::string, int> getLocalAddress() const;
+	std::tuple<std::string, int> getPeerAddress() const;
+
+	// Events are EPOLLIN/EPOLLOUT, replaced on each call
+	void watch(uint32_t events, std::function<void(uint32_t)> callback);
+	void unwatch();
+	void close();
+};
@@ -0,0 +1,98 @@
+#include "transport.h"
+#include "framing.h"
+#include "sharedring.h"
+
+#include <unistd.h>
+#include <memory>
+
+namespace Transport {
+static int fdToParent;
+static Framing::Reader reader;
+// Used for messages instead of the pipes when the server passed a region
+static std::unique_ptr<SharedRing::Region> shared;
+static pid_t parentPID;
+
+bool init(int fdFromServer, int fdToServer, int sharedFD) {
+	fdToParent = fdToServer;
+	reader.setFD(fdFromServer);
+	parentPID = getppid();
+
+	if (sharedFD != -1) {
+		try {
+			shared.reset(SharedRing::Region::attach(sharedFD));
+		} catch (const std::exception&) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool readMessage(std::string& message) {
+	if (shared) return shared->toSatellite.tryRead(message);
+
+	bool isControl;
+	while (reader.read(message, isControl))
+		if (!isControl) return true;
+	return false;
+}
+
+bool nextBufferedMessage(std::string& message) {
+	if (shared) return shared->toSatellite.tryRead(message);
+
+	bool isControl;
+	while (reader.next(message, isControl))
+		if (!isControl) return true;
+	return false;
+}
+
+void writeMessage(const std::string& message) {
+	if (shared) {
+		// Orphaned satellites are reparented, so this notices the server exiting
+		shared->toServer.write(message.data(), message.size(),
+		                       []() { return getppid() == parentPID; });
+		return;
+	}
+
+	Framing::write(fdToParent, message);
+}
+
+bool readFrame(std::string& frame, bool& isControl) {
+	return reader.read(frame, isControl);
+}
+
+void writeControl(const std::string& frame) {
+	Framing::write(fdToParent, frame, true);
+}
+
+void waitForFrame() { reader.wait(); }
+
+int getServerFD() { return reader.getFD(); }
+
+bool pollServer() {
+	reader.fill();
+
+	// Only wake ups come through the pipe alongside a shared ring
+	if (shared) {
+		std::string frame;
+		bool isControl;
+		while (reader.next(frame, isControl))
+			;
+	}
+
+	return !reader.isClosed();
+}
+
+bool hasMessage() {
+	if (shared) return !shared->toSatellite.isEmpty();
+	return reader.hasFrame();
+}
+
+void beginWait() {
+	if (shared) shared->toSatellite.setReaderPolling(true);
+}
+
+void endWait() {
+	if (shared) shared->toSatellite.setReaderPolling(false);
+}
+}  // namespace Transport
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+// Messages to and from the server, over the pipes or a shared ring region
+namespace Transport {
+// Returns false if the shared ring region couldn't be mapped
+bool init(int fdFromServer, int fdToServer, int sharedFD);
+
+// Scripts only see regular frames, the server never sends control frames
+// while a job is running
+bool readMessage(std::string& message);
+// Only takes what has already been read, without touching the pipe
+bool nextBufferedMessage(std::string& message);
+void writeMessage(const std::string& message);
+
+// For pooled satellites, waiting for jobs between scripts
+bool readFrame(std::string& frame, bool& isControl);
+void writeControl(const std::string& frame);
+void waitForFrame();
+
+// The pipe to watch for incoming messages and the server exiting
+int getServerFD();
+// Drains the server pipe into the buffer. Returns false once the server is
+// gone and nothing is left.
+bool pollServer();
+// Whether a message can be read without waiting
+bool hasMessage();
+// Brackets waiting on the server pipe, so messages sent through a shared ring
+// also wake us up
+void beginWait();
+void endWait();
+}  // namespace Transport
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Length-prefixed messages over the pipes between the server and satellites.
+// Each frame is a native-endian uint32 length followed by that many bytes.
+namespace Framing {
+// Set in the length of frames meant for RosaServer itself, not scripts
+static constexpr uint32_t controlBit = 0x80000000;
+// Control frames start with one of these
+enum Control : char {
+	// Server to pooled satellite, followed by a file name or Lua source
+	controlRunFile = 'f',
+	controlRunChunk = 'c',
+	// Satellite to server, followed by a status byte
+	controlJobDone = 'd',
+	// Server to satellite, when a message went through a shared ring while the
+	// satellite was waiting on the pipe
+	controlWake = 'w'
+};
+
+// Anything bigger is a desynchronized or corrupt stream
+static constexpr uint32_t maxFrameLength = 64 * 1024 * 1024;
+static constexpr size_t readChunkSize = 64 * 1024;
+
+// Buffers whatever is available, so frames split across reads aren't lost
+class Reader {
+	int fd;
+	std::string buffer;
+	// Start of the first unconsumed byte in buffer
+	size_t position = 0;
+	bool closed = false;
+
+ public:
+	Reader(int fd = -1) : fd(fd) {}
+
+	void setFD(int newFD) { fd = newFD; }
+	int getFD() const { return fd; }
+	// True once the other end has closed and every frame has been taken
+	bool isClosed() const { return closed && buffer.size() == position; }
+
+	// Reads everything currently available without blocking (when the fd is
+	// non-blocking). Returns false if nothing new arrived.
+	bool fill() {
+		if (closed) return false;
+
+		if (position == buffer.size()) {
+			buffer.clear();
+			position = 0;
+		} else if (position >= readChunkSize) {
+			buffer.erase(0, position);
+			position = 0;
+		}
+
+		bool gotData = false;
+		while (true) {
+			size_t oldSize = buffer.size();
+			buffer.resize(oldSize + readChunkSize);
+
+			auto bytesRead = ::read(fd, &buffer[oldSize], readChunkSize);
+			if (bytesRead > 0) {
+				buffer.resize(oldSize + bytesRead);
+				gotData = true;
+				// A short read means the pipe is drained
+				if (static_cast<size_t>(bytesRead) < readChunkSize) break;
+				continue;
+			}
+
+			buffer.resize(oldSize);
+			if (bytesRead == 0) {
+				closed = true;
+				break;
+			}
+			if (errno == EINTR) continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+			throw std::runtime_error(strerror(errno));
+		}
+
+		return gotData;
+	}
+
+	// Takes the next complete frame out of the buffer, without reading
+	bool next(std::string& frame, bool& isControl) {
+		size_t available = buffer.size() - position;
+		if (available < sizeof(uint32_t)) return false;
+
+		uint32_t length;
+		std::memcpy(&length, &buffer[position], sizeof(length));
+		isControl = length & controlBit;
+		length &= ~controlBit;
+		if (length > maxFrameLength)
+			throw std::runtime_error("Message is too large, stream is corrupt");
+		if (available - sizeof(length) < length) return false;
+
+		frame.assign(buffer, position + sizeof(length), length);
+		position += sizeof(length) + length;
+		return true;
+	}
+
+	// Whether a complete frame is buffered
+	bool hasFrame() const {
+		size_t available = buffer.size() - position;
+		if (available < sizeof(uint32_t)) return false;
+
+		uint32_t length;
+		std::memcpy(&length, &buffer[position], sizeof(length));
+		return available - sizeof(length) >= (length & ~controlBit);
+	}
+
+	// Returns a buffered frame, only reading if there isn't one
+	bool read(std::string& frame, bool& isControl) {
+		if (next(frame, isControl)) return true;
+		return fill() && next(frame, isControl);
+	}
+
+	// Blocks until something arrives or the other end closes
+	void wait() {
+		pollfd waitFor{fd, POLLIN, 0};
+		while (poll(&waitFor, 1, -1) == -1 && errno == EINTR)
+			;
+	}
+};
+
+// Writes the header and body with one syscall, finishing partial writes
+inline void write(int fd, const char* data, size_t length,
+                  bool isControl = false) {
+	if (length > maxFrameLength) throw std::runtime_error("Message is too large");
+
+	uint32_t header = static_cast<uint32_t>(length);
+	if (isControl) header |= controlBit;
+	iovec parts[2] = {{&header, sizeof(header)},
+	                  {const_cast<char*>(data), length}};
+	iovec* part = parts;
+	int numParts = 2;
+
+	while (numParts) {
+		auto bytesWritten = writev(fd, part, numParts);
+		if (bytesWritten == -1) {
+			if (errno == EINTR) continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				pollfd waitFor{fd, POLLOUT, 0};
+				poll(&waitFor, 1, -1);
+				continue;
+			}
+			throw std::runtime_error(strerror(errno));
+		}
+
+		size_t written = bytesWritten;
+		while (numParts && written >= part->iov_len) {
+			written -= part->iov_len;
+			part++;
+			numParts--;
+		}
+		if (numParts) {
+			part->iov_base = static_cast<char*>(part->iov_base) + written;
+			part->iov_len -= written;
+		}
+	}
+}
+
+inline void write(int fd, const std::string& message, bool isControl = false) {
+	write(fd, message.data(), message.size(), isControl);
+}
+}  // namespace Framing
@@ -0,0 +1,347 @@
+#pragma once
+#include "sol/sol.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Compact binary encoding of Lua values, readable by any state in either
+// process. Tables are copied by value; userdata needs a codec.
+namespace Serialize {
+static constexpr uint8_t formatVersion = 1;
+static constexpr int maxDepth = 200;
+
+enum Tag : uint8_t {
+	tagNil,
+	tagFalse,
+	tagTrue,
+	// Integral numbers, as a zigzag varint
+	tagInteger,
+	tagNumber,
+	tagString,
+	tagTable,
+	// Followed by a codec-defined type byte and payload
+	tagExtension
+};
+
+class Reader {
+	const char* position;
+	const char* end;
+
+ public:
+	Reader(const char* data, size_t length)
+	    : position(data), end(data + length) {}
+
+	bool atEnd() const { return position == end; }
+	size_t remaining() const { return end - position; }
+
+	void read(void* out, size_t length) {
+		if (static_cast<size_t>(end - position) < length)
+			throw std::runtime_error("Malformed serialized data");
+		std::memcpy(out, position, length);
+		position += length;
+	}
+
+	uint8_t readByte() {
+		uint8_t byte;
+		read(&byte, 1);
+		return byte;
+	}
+
+	uint64_t readVarint() {
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			uint8_t byte = readByte();
+			value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) return value;
+		}
+		throw std::runtime_error("Malformed serialized data");
+	}
+
+	const char* skip(size_t length) {
+		const char* start = position;
+		if (static_cast<size_t>(end - position) < length)
+			throw std::runtime_error("Malformed serialized data");
+		position += length;
+		return start;
+	}
+};
+
+inline void writeVarint(std::string& out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+inline void write(std::string& out, const void* data, size_t length) {
+	out.append(static_cast<const char*>(data), length);
+}
+
+class Codec {
+ public:
+	// Appends a type byte and payload for the value at index, or returns false if
+	// it isn't one this codec handles
+	virtual bool encode(lua_State* L, int index, std::string& out) const = 0;
+	// Pushes a value of the given type, or returns false if it's unknown
+	virtual bool decode(lua_State* L, uint8_t type, Reader& reader) const = 0;
+	virtual ~Codec() = default;
+};
+
+namespace detail {
+class Encoder {
+	lua_State* L;
+	std::string& out;
+	const Codec* codec;
+	// Tables currently being encoded, to catch cycles
+	std::vector<const void*> path;
+
+	void encodeNumber(double number) {
+		if (std::fabs(number) < 9007199254740992.0 &&
+		    number == static_cast<double>(static_cast<int64_t>(number)) &&
+		    !(number == 0 && std::signbit(number))) {
+			int64_t integer = static_cast<int64_t>(number);
+			out.push_back(tagInteger);
+			writeVarint(out, (static_cast<uint64_t>(integer) << 1) ^
+			                     static_cast<uint64_t>(integer >> 63));
+			return;
+		}
+
+		out.push_back(tagNumber);
+		write(out, &number, sizeof(number));
+	}
+
+	void encodeTable(int index) {
+		const void* pointer = lua_topointer(L, index);
+		for (const void* parent : path)
+			if (parent == pointer)
+				throw std::runtime_error("Cannot serialize a table containing itself");
+		if (path.size() >= maxDepth)
+			throw std::runtime_error("Table nesting is too deep to serialize");
+		path.push_back(pointer);
+
+		luaL_checkstack(L, 4, "Table nesting is too deep to serialize");
+
+		size_t arrayLength = lua_objlen(L, index);
+		size_t hashCount = 0;
+		lua_pushnil(L);
+		while (lua_next(L, index)) {
+			lua_pop(L, 1);
+			if (!isArrayKey(-1, arrayLength)) hashCount++;
+		}
+
+		out.push_back(tagTable);
+		writeVarint(out, arrayLength);
+		writeVarint(out, hashCount);
+		for (size_t i = 1; i <= arrayLength; i++) {
+			lua_rawgeti(L, index, i);
+			encode(lua_gettop(L));
+			lua_pop(L, 1);
+		}
+
+		lua_pushnil(L);
+		while (lua_next(L, index)) {
+			if (!isArrayKey(-2, arrayLength)) {
+				encode(lua_gettop(L) - 1);
+				encode(lua_gettop(L));
+			}
+			lua_pop(L, 1);
+		}
+
+		path.pop_back();
+	}
+
+	bool isArrayKey(int index, size_t arrayLength) {
+		if (lua_type(L, index) != LUA_TNUMBER) return false;
+		double key = lua_tonumber(L, index);
+		return key >= 1 && key <= arrayLength &&
+		       key == static_cast<double>(static_cast<size_t>(key));
+	}
+
+ public:
+	Encoder(lua_State* L, std::string& out, const Codec* codec)
+	    : L(L), out(out), codec(codec) {}
+
+	void encode(int index) {
+		switch (lua_type(L, index)) {
+			case LUA_TNIL:
+				out.push_back(tagNil);
+				break;
+			case LUA_TBOOLEAN:
+				out.push_back(lua_toboolean(L, index) ? tagTrue : tagFalse);
+				break;
+			case LUA_TNUMBER:
+				encodeNumber(lua_tonumber(L, index));
+				break;
+			case LUA_TSTRING: {
+				size_t length;
+				const char* string = lua_tolstring(L, index, &length);
+				out.push_back(tagString);
+				writeVarint(out, length);
+				write(out, string, length);
+				break;
+			}
+			case LUA_TTABLE:
+				encodeTable(index);
+				break;
+			case LUA_TUSERDATA: {
+				size_t start = out.size();
+				out.push_back(tagExtension);
+				if (codec && codec->encode(L, index, out)) break;
+				out.resize(start);
+				[[fallthrough]];
+			}
+			default:
+				throw std::runtime_error(std::string("Cannot serialize a ") +
+				                         luaL_typename(L, index));
+		}
+	}
+};
+
+class Decoder {
+	lua_State* L;
+	Reader& reader;
+	const Codec* codec;
+	int depth = 0;
+
+	void decodeTable() {
+		if (++depth > maxDepth)
+			throw std::runtime_error("Table nesting is too deep to deserialize");
+		luaL_checkstack(L, 4, "Table nesting is too deep to deserialize");
+
+		uint64_t arrayLength = reader.readVarint();
+		uint64_t hashCount = reader.readVarint();
+		// Don't trust the counts with more than the data could actually hold
+		lua_createtable(L, std::min<uint64_t>(arrayLength, reader.remaining()),
+		                std::min<uint64_t>(hashCount, reader.remaining() / 2));
+		int table = lua_gettop(L);
+
+		for (uint64_t i = 1; i <= arrayLength; i++) {
+			decode();
+			lua_rawseti(L, table, i);
+		}
+
+		for (uint64_t i = 0; i < hashCount; i++) {
+			decode();
+			if (lua_isnil(L, -1) ||
+			    (lua_type(L, -1) == LUA_TNUMBER && std::isnan(lua_tonumber(L, -1))))
+				throw std::runtime_error("Malformed serialized data");
+			decode();
+			lua_rawset(L, table);
+		}
+
+		depth--;
+	}
+
+ public:
+	Decoder(lua_State* L, Reader& reader, const Codec* codec)
+	    : L(L), reader(reader), codec(codec) {}
+
+	void decode() {
+		switch (reader.readByte()) {
+			case tagNil:
+				lua_pushnil(L);
+				break;
+			case tagFalse:
+				lua_pushboolean(L, false);
+				break;
+			case tagTrue:
+				lua_pushboolean(L, true);
+				break;
+			case tagInteger: {
+				uint64_t zigzag = reader.readVarint();
+				int64_t integer =
+				    static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+				lua_pushnumber(L, static_cast<double>(integer));
+				break;
+			}
+			case tagNumber: {
+				double number;
+				reader.read(&number, sizeof(number));
+				lua_pushnumber(L, number);
+				break;
+			}
+			case tagString: {
+				uint64_t length = reader.readVarint();
+				const char* string = reader.skip(length);
+				lua_pushlstring(L, string, length);
+				break;
+			}
+			case tagTable:
+				decodeTable();
+				break;
+			case tagExtension: {
+				uint8_t type = reader.readByte();
+				if (!codec || !codec->decode(L, type, reader))
+					throw std::runtime_error("Unsupported serialized type");
+				break;
+			}
+			default:
+				throw std::runtime_error("Malformed serialized data");
+		}
+	}
+};
+}  // namespace detail
+
+// Appends the value at index to out
+inline void encode(lua_State* L, int index, std::string& out,
+                   const Codec* codec = nullptr) {
+	index = lua_absindex(L, index);
+	out.push_back(formatVersion);
+
+	int top = lua_gettop(L);
+	try {
+		detail::Encoder(L, out, codec).encode(index);
+	} catch (...) {
+		lua_settop(L, top);
+		throw;
+	}
+}
+
+// Pushes the decoded value
+inline void decode(lua_State* L, const char* data, size_t length,
+                   const Codec* codec = nullptr) {
+	Reader reader(data, length);
+	if (reader.readByte() != formatVersion)
+		throw std::runtime_error("Unsupported serialized data version");
+
+	int top = lua_gettop(L);
+	try {
+		detail::Decoder(L, reader, codec).decode();
+		if (!reader.atEnd()) throw std::runtime_error("Malformed serialized data");
+	} catch (...) {
+		lua_settop(L, top);
+		throw;
+	}
+}
+
+inline std::string encode(const sol::object& value,
+                          const Codec* codec = nullptr) {
+	lua_State* L = value.lua_state();
+	std::string out;
+
+	value.push();
+	try {
+		encode(L, -1, out, codec);
+	} catch (...) {
+		lua_pop(L, 1);
+		throw;
+	}
+	lua_pop(L, 1);
+
+	return out;
+}
+
+inline sol::object decode(lua_State* L, const std::string& data,
+                          const Codec* codec = nullptr) {
+	decode(L, data.data(), data.size(), codec);
+	sol::object value(L, -1);
+	lua_pop(L, 1);
+	return value;
+}
+}  // namespace Serialize
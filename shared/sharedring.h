@@ -0,0 +1,225 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+// Message rings in a memfd mapped by both the server and a satellite, one
+// for each direction. Each side only ever writes one ring and reads the
+// other, so neither needs a lock or a syscall unless it has to wait.
+namespace SharedRing {
+static constexpr size_t minCapacity = 4096;
+static constexpr size_t maxCapacity = 1024 * 1024 * 1024;
+
+// Shared between processes, so these can't be FUTEX_PRIVATE
+inline void futexWait(std::atomic_uint32_t* word, uint32_t expected,
+                      int timeoutMs) {
+	timespec timeout{timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+	syscall(SYS_futex, word, FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+inline void futexWake(std::atomic_uint32_t* word) {
+	syscall(SYS_futex, word, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+struct Header {
+	// Only written by the producer
+	alignas(64) std::atomic_uint64_t writePosition;
+	// Set while the reader waits on something other than the futex
+	std::atomic_uint32_t readerPolling;
+	// Only written by the consumer
+	alignas(64) std::atomic_uint64_t readPosition;
+	std::atomic_uint32_t readSequence;
+	std::atomic_uint32_t writerWaiting;
+};
+
+static_assert(std::atomic_uint64_t::is_always_lock_free &&
+                  std::atomic_uint32_t::is_always_lock_free,
+              "Shared memory atomics must be lock free");
+
+// Messages are a uint32 length and the bytes, wrapping around the end
+class Ring {
+	Header* header;
+	char* data;
+	uint64_t capacity;
+
+	void copyIn(uint64_t position, const void* source, size_t length) {
+		size_t offset = position & (capacity - 1);
+		size_t first = std::min<size_t>(length, capacity - offset);
+		std::memcpy(data + offset, source, first);
+		std::memcpy(data, static_cast<const char*>(source) + first,
+		            length - first);
+	}
+
+	void copyOut(uint64_t position, void* destination, size_t length) const {
+		size_t offset = position & (capacity - 1);
+		size_t first = std::min<size_t>(length, capacity - offset);
+		std::memcpy(destination, data + offset, first);
+		std::memcpy(static_cast<char*>(destination) + first, data,
+		            length - first);
+	}
+
+	bool hasSpace(uint64_t needed) const {
+		uint64_t used = header->writePosition.load(std::memory_order_relaxed) -
+		                header->readPosition.load();
+		return capacity - used >= needed;
+	}
+
+ public:
+	Ring() : header(nullptr), data(nullptr), capacity(0) {}
+	Ring(Header* header, char* data, uint64_t capacity)
+	    : header(header), data(data), capacity(capacity) {}
+
+	bool isEmpty() const {
+		return header->readPosition.load(std::memory_order_relaxed) ==
+		       header->writePosition.load();
+	}
+
+	// Returns false if there isn't room right now
+	bool tryWrite(const char* message, uint32_t length) {
+		uint64_t needed = sizeof(length) + static_cast<uint64_t>(length);
+		if (!hasSpace(needed)) return false;
+
+		uint64_t position = header->writePosition.load(std::memory_order_relaxed);
+		copyIn(position, &length, sizeof(length));
+		copyIn(position + sizeof(length), message, length);
+		header->writePosition.store(position + needed);
+		return true;
+	}
+
+	// Waits for room, checking now and then that the reader still exists
+	void write(const char* message, uint32_t length,
+	           const std::function<bool()>& isPeerAlive) {
+		if (sizeof(length) + static_cast<uint64_t>(length) > capacity)
+			throw std::runtime_error("Message is too large for the shared ring");
+
+		while (!tryWrite(message, length)) {
+			uint32_t sequence = header->readSequence.load();
+			header->writerWaiting.store(1);
+			if (!hasSpace(sizeof(length) + static_cast<uint64_t>(length)))
+				futexWait(&header->readSequence, sequence, 100);
+			header->writerWaiting.store(0);
+
+			if (!isPeerAlive())
+				throw std::runtime_error("Other end of the shared ring has exited");
+		}
+	}
+
+	// The other process can write anything into the header and data, so
+	// nothing read from them is trusted to be in bounds
+	bool tryRead(std::string& message) {
+		uint64_t position = header->readPosition.load(std::memory_order_relaxed);
+		uint64_t available = header->writePosition.load() - position;
+		if (!available) return false;
+
+		uint32_t length;
+		if (available < sizeof(length) || available > capacity)
+			throw std::runtime_error("Shared ring is corrupt");
+		copyOut(position, &length, sizeof(length));
+		if (length > available - sizeof(length))
+			throw std::runtime_error("Message is too large, shared ring is corrupt");
+
+		message.resize(length);
+		copyOut(position + sizeof(length), &message[0], length);
+		header->readPosition.store(position + sizeof(length) + length);
+
+		if (header->writerWaiting.load()) {
+			header->readSequence.fetch_add(1);
+			futexWake(&header->readSequence);
+		}
+		return true;
+	}
+
+	// For a reader that waits in epoll, the writer checks this after writing
+	// and wakes it some other way
+	void setReaderPolling(bool polling) { header->readerPolling.store(polling); }
+	bool isReaderPolling() const { return header->readerPolling.load(); }
+};
+
+// The mapping: both headers, then the server-to-satellite data, then the
+// satellite-to-server data
+class Region {
+	int fd = -1;
+	void* memory = MAP_FAILED;
+	size_t length = 0;
+
+	void map(uint64_t capacity) {
+		length = 2 * sizeof(Header) + 2 * capacity;
+		memory =
+		    mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (memory == MAP_FAILED) throw std::runtime_error(strerror(errno));
+
+		auto headers = static_cast<Header*>(memory);
+		char* ringData = static_cast<char*>(memory) + 2 * sizeof(Header);
+		toSatellite = Ring(&headers[0], ringData, capacity);
+		toServer = Ring(&headers[1], ringData + capacity, capacity);
+	}
+
+ public:
+	Ring toSatellite;
+	Ring toServer;
+
+	// Creates a region with at least capacity bytes each way
+	explicit Region(size_t capacity) {
+		if (capacity > maxCapacity)
+			throw std::invalid_argument("Shared ring is too large");
+		uint64_t rounded = minCapacity;
+		while (rounded < capacity) rounded <<= 1;
+
+		fd = memfd_create("rosaserver-ring", MFD_CLOEXEC);
+		if (fd == -1) throw std::runtime_error(strerror(errno));
+
+		// Fresh memfd pages are zeroed, which is a valid empty header
+		if (ftruncate(fd, 2 * sizeof(Header) + 2 * rounded) == -1) {
+			int err = errno;
+			close(fd);
+			throw std::runtime_error(strerror(err));
+		}
+
+		try {
+			map(rounded);
+		} catch (...) {
+			close(fd);
+			throw;
+		}
+	}
+
+	// Maps a region created by the other process
+	static Region* attach(int fd) {
+		struct stat info;
+		if (fstat(fd, &info) == -1) throw std::runtime_error(strerror(errno));
+		if (info.st_size < static_cast<off_t>(2 * sizeof(Header)))
+			throw std::runtime_error("Shared ring region is too small");
+
+		std::unique_ptr<Region> region(new Region());
+		region->fd = fd;
+		region->map((info.st_size - 2 * sizeof(Header)) / 2);
+		return region.release();
+	}
+
+	Region(const Region&) = delete;
+	Region& operator=(const Region&) = delete;
+
+	~Region() {
+		if (memory != MAP_FAILED) munmap(memory, length);
+		if (fd != -1) close(fd);
+	}
+
+	int getFD() const { return fd; }
+
+ private:
+	Region() = default;
+};
+}  // namespace SharedRing
@@ -0,0 +1,7 @@
+while true do
+	local message = receiveMessage()
+	if message then
+		if message == 'quit' then break end
+		sendMessage(message)
+	end
+end
\ No newline at end of file
@@ -0,0 +1,67 @@
+local numSpawns = 50
+local numMessages = 100000
+
+do
+	local spawnTime = 0
+	local readyTime = 0
+
+	for _ = 1, numSpawns do
+		local start = os.realClock()
+		local child = ChildProcess.new('benchmarks/childProcess.satellite.lua')
+		spawnTime = spawnTime + os.realClock() - start
+
+		-- Includes exec and the satellite's Lua start up
+		while not child:receiveMessage() do end
+		readyTime = readyTime + os.realClock() - start
+
+		child:terminate()
+	end
+
+	benchLog('%-36s %8.2f us', 'child process spawn', spawnTime / numSpawns * 1000000)
+	benchLog('%-36s %8.2f us', 'child process first message', readyTime / numSpawns * 1000000)
+end
+
+do
+	local pool = SatellitePool.new(2)
+	local readyTime = 0
+
+	for _ = 1, numSpawns do
+		local start = os.realClock()
+		local child = pool:acquireChunk("sendMessage('ready')")
+
+		while not child:receiveMessage() do end
+		readyTime = readyTime + os.realClock() - start
+
+		while not child:getJobStatus() do end
+		pool:release(child)
+	end
+
+	local stats = pool:getStats()
+	benchLog('%-36s %8.2f us %6i misses', 'pooled satellite first message', readyTime / numSpawns * 1000000, stats.misses)
+end
+
+local function echoThroughput (name, options)
+	local fileName = 'benchmarks/childProcess.echo.lua'
+	local child = options and ChildProcess.new(fileName, options) or ChildProcess.new(fileName)
+	local payload = string.rep('x', 64)
+	local sent = 0
+	local received = 0
+
+	local start = os.realClock()
+	while received < numMessages do
+		-- Keep the pipe from filling up and blocking
+		if sent < numMessages and sent - received < 500 then
+			child:sendMessage(payload)
+			sent = sent + 1
+		end
+
+		received = received + #child:receiveMessages()
+	end
+	local elapsed = os.realClock() - start
+
+	child:sendMessage('quit')
+	benchLog('%-36s %8.0f msg/s', name, numMessages / elapsed)
+end
+
+echoThroughput('child process echo (pipes)')
+echoThroughput('child process echo (shared ring)', { ringSize = 1024 * 1024 })
\ No newline at end of file
@@ -0,0 +1 @@
+sendMessage('ready')
\ No newline at end of file
@@ -0,0 +1,53 @@
+local iterations = 1000000
+
+local function bench (name, func)
+	collectgarbage()
+	local gcBefore = collectgarbage('count')
+	local start = os.realClock()
+	func()
+	local elapsed = os.realClock() - start
+	local gcAfter = collectgarbage('count')
+	benchLog('%-36s %8.2f ms %10.1f KiB', name, elapsed * 1000, gcAfter - gcBefore)
+end
+
+local function run (label, Vector, RotMatrix)
+	local rot = RotMatrix(
+		0, -1, 0,
+		1, 0, 0,
+		0, 0, 1
+	)
+
+	bench(label .. ' a + b * s', function ()
+		local a = Vector(0, 0, 0)
+		local b = Vector(1, 2, 3)
+		for _ = 1, iterations do
+			a = a + b * 0.5
+		end
+	end)
+
+	bench(label .. ' (a - b):length()', function ()
+		local a = Vector(1, 2, 3)
+		local b = Vector(3, 2, 1)
+		local total = 0
+		for _ = 1, iterations do
+			total = total + (a - b):length()
+		end
+	end)
+
+	bench(label .. ' v * rot', function ()
+		local v = Vector(1, 0, 0)
+		for _ = 1, iterations do
+			v = v * rot
+		end
+	end)
+
+	bench(label .. ' rot * rot', function ()
+		local r = rot:clone()
+		for _ = 1, iterations do
+			r = r * rot
+		end
+	end)
+end
+
+run('userdata', Vector, RotMatrix)
+run('ffi', ffiMath.Vector, ffiMath.RotMatrix)
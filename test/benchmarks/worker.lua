@@ -0,0 +1,52 @@
+local roundTrips = 10000
+local numMessages = 200000
+
+local worker = assert(Worker.new('benchmarks/worker.worker.lua'))
+
+local function receive ()
+	local message
+	repeat
+		message = worker:receiveMessage()
+	until message
+	return message
+end
+
+-- Wait for the thread to start up
+assert(worker:sendMessage('ping'))
+receive()
+
+do
+	local start = os.realClock()
+	for _ = 1, roundTrips do
+		worker:sendMessage('ping')
+		receive()
+	end
+	local elapsed = os.realClock() - start
+	benchLog('%-36s %8.2f us', 'worker round trip', elapsed / roundTrips * 1000000)
+end
+
+do
+	local payload = string.rep('x', 64)
+	local sent = 0
+	local received = 0
+	local rejected = 0
+
+	local start = os.realClock()
+	while received < numMessages do
+		if sent < numMessages then
+			if worker:sendMessage(payload) then
+				sent = sent + 1
+			else
+				rejected = rejected + 1
+			end
+		end
+
+		while worker:receiveMessage() do
+			received = received + 1
+		end
+	end
+	local elapsed = os.realClock() - start
+	benchLog('%-36s %8.0f msg/s %10i full', 'worker echo throughput', numMessages / elapsed, rejected)
+end
+
+worker:stop()
\ No newline at end of file
@@ -0,0 +1,12 @@
+while true do
+	local message = receiveMessage(-1)
+	if not message then
+		return
+	end
+
+	while not sendMessage(message) do
+		if sleep(0) then
+			return
+		end
+	end
+end
\ No newline at end of file
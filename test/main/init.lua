@@ -8,23 +8,51 @@ local function runTests ()
 	require('tests.bonds')
 	require('tests.bullets')
 	require('tests.chat')
+	require('tests.childProcess')
 	require('tests.event')
+	require('tests.ffiMath')
+	require('tests.flightRecorder')
 	require('tests.http')
+	require('tests.httpServer')
 	require('tests.humans')
 	require('tests.image')
 	require('tests.items')
 	require('tests.itemTypes')
+	require('tests.jobs')
+	require('tests.logger')
+	require('tests.luaErrors')
 	require('tests.memory')
 	require('tests.os')
 	require('tests.physics')
 	require('tests.players')
 	require('tests.rigidBodies')
 	require('tests.rotMatrix')
+	require('tests.satelliteEventLoop')
+	require('tests.satellitePool')
+	require('tests.satelliteSockets')
+	require('tests.serialize')
 	require('tests.server')
+	require('tests.sharedRing')
+	require('tests.sharedTable')
 	require('tests.streets')
 	require('tests.vector')
 	require('tests.vehicles')
+	require('tests.webhook')
 	require('tests.worker')
+	require('tests.world')
+end
+
+local isBenchmark = os.getenv('ROSA_BENCHMARK') ~= nil
+
+function benchLog (...)
+	local prefix = '\27[35;1m[Bench]\27[0m '
+	print(prefix .. string.format(...))
+end
+
+local function runBenchmarks ()
+	require('benchmarks.childProcess')
+	require('benchmarks.vector')
+	require('benchmarks.worker')
 end
 
 local function testsPassed ()
@@ -51,7 +79,7 @@ function hook.run (event, ...)
 		log('Tick %i...', tick, maxTicks)
 
 		if tick == 1 then
-			protectedFailCall(runTests)
+			protectedFailCall(isBenchmark and runBenchmarks or runTests)
 		else
 			for i = #handlers, 1, -1 do
 				local handler = handlers[i]
@@ -0,0 +1,30 @@
+local child = assert(ChildProcess.new('tests/childProcess.satellite.lua'))
+
+local expected = { string.rep('0123456789', 20000) }
+for i = 1, 5 do
+	table.insert(expected, 'small ' .. i)
+end
+
+local received = {}
+local ticks = 0
+
+local function pump ()
+	ticks = ticks + 1
+
+	for _, message in ipairs(child:receiveMessages()) do
+		table.insert(received, message)
+	end
+
+	if #received < #expected then
+		assert(ticks < 600, 'Child process messages timed out')
+		nextTick(pump)
+		return
+	end
+
+	assert(#received == #expected)
+	for i, message in ipairs(expected) do
+		assert(received[i] == message, 'Message ' .. i .. ' damaged or out of order')
+	end
+end
+
+nextTick(pump)
\ No newline at end of file
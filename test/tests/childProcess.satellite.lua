@@ -0,0 +1,6 @@
+-- Bigger than the 64K pipe buffer, so it arrives over several reads
+sendMessage(string.rep('0123456789', 20000))
+
+for i = 1, 5 do
+	sendMessage('small ' .. i)
+end
\ No newline at end of file
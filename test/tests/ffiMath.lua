@@ -0,0 +1,88 @@
+local FVector = ffiMath.Vector
+local FRotMatrix = ffiMath.RotMatrix
+
+local vector = FVector(1, 2, 3.5)
+assert(vector.class == 'Vector')
+assert(vector.x == 1)
+assert(vector.y == 2)
+assert(vector.z == 3.5)
+
+vector:add(FVector(0, 0, -0.5))
+assert(vector.z == 3)
+
+vector:mult(2)
+assert(vector == FVector(2, 4, 6))
+
+vector:set(Vector(1, 2, 3))
+assert(vector == FVector(1, 2, 3))
+
+local sum = vector + FVector(3, 2, 1)
+assert(sum:dist(FVector(4, 4, 4)) == 0)
+
+local scaled = vector * 2
+assert(scaled == FVector(2, 4, 6))
+
+local rotated = FVector(1, 0, 0) * FRotMatrix(
+	0, -1, 0,
+	1, 0, 0,
+	0, 0, 1
+)
+assert(rotated == FVector(0, 1, 0))
+
+local crossed = FVector(1, 0, 0)
+crossed:cross(FVector(0, 1, 0))
+assert(crossed == FVector(0, 0, 1))
+
+local blockX, blockY, blockZ = FVector(-5, 4, 9):getBlockPos()
+assert(blockX == -1)
+assert(blockY == 1)
+assert(blockZ == 2)
+
+local converted = FVector(1, 2, 3):toVector()
+assert(converted.class == 'Vector')
+assert(converted:dist(Vector(1, 2, 3)) == 0)
+
+local source = Vector(1, 2, 3)
+local view = ffiMath.viewVector(source)
+view.x = 5
+assert(source.x == 5)
+source.y = 7
+assert(view.y == 7)
+
+local rot = RotMatrix(
+	1, 0, 0,
+	0, 1, 0,
+	0, 0, 1
+)
+local rotView = ffiMath.viewRotMatrix(rot)
+rotView.x1 = -1
+assert(rot.x1 == -1)
+
+local rotCopy = ffiMath.fromRotMatrix(rot)
+rotCopy.x1 = 1
+assert(rot.x1 == -1)
+assert(rotCopy:getForward() == FVector(1, 0, 0))
+assert(rotCopy:toRotMatrix().class == 'RotMatrix')
+
+local accumulated = FVector(1, 1, 1)
+accumulated:addScaled(FVector(1, 2, 3), 2)
+assert(accumulated == FVector(3, 5, 7))
+
+local identity = FRotMatrix(
+	1, 0, 0,
+	0, 1, 0,
+	0, 0, 1
+)
+local quarterTurn = identity:clone()
+quarterTurn:fromEuler(0, 0, math.pi / 2)
+
+local rotatedInPlace = FVector(1, 0, 0)
+rotatedInPlace:rotateBy(quarterTurn)
+assert(rotatedInPlace:dist(FVector(1, 0, 0) * quarterTurn) == 0)
+
+local eighthTurn = identity:clone()
+eighthTurn:fromEuler(0, 0, math.pi / 4)
+
+local interpolated = identity:clone()
+interpolated:slerp(quarterTurn, 0.5)
+assert(interpolated:getForward():dist(eighthTurn:getForward()) < 0.0001)
\ No newline at end of file
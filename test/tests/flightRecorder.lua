@@ -0,0 +1,37 @@
+-- The tests run from inside the Logic hook, so its dispatch is still going
+local found = false
+for _, entry in ipairs(flightRecorder.getRecent(16384)) do
+	assert(type(entry.tick) == 'number')
+	assert(entry.secondsAgo >= 0)
+	if entry.event == 'Logic' and not entry.durationSeconds then
+		assert(entry.entity == nil)
+		found = true
+	end
+end
+assert(found)
+
+assert(#flightRecorder.getRecent(1) == 1)
+assert(#flightRecorder.getRecent(0) == 0)
+
+local path = os.tmpname()
+flightRecorder.dump(path)
+
+local file = assert(io.open(path))
+local contents = file:read('*a')
+file:close()
+os.remove(path)
+
+assert(contents:find('^Last %d+ hook dispatches'))
+assert(contents:find('Logic was still running'))
+
+assert(not pcall(flightRecorder.dump, '/nonexistent/directory/dump.txt'))
+
+nextTick(function ()
+	local recent = flightRecorder.getRecent(16384)
+	for _, entry in ipairs(recent) do
+		if entry.event == 'Logic' and entry.durationSeconds then
+			return
+		end
+	end
+	error('finished Logic dispatch not recorded')
+end)
\ No newline at end of file
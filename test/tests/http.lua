@@ -11,4 +11,64 @@ for k, v in pairs(res.headers) do
 		break
 	end
 end
-assert(foundContentType)
\ No newline at end of file
+assert(foundContentType)
+
+local asyncDone = false
+local asyncResponse
+
+http.get('https://github.com', '/robots.txt', {}, function (res)
+	asyncDone = true
+	asyncResponse = res
+end)
+assert(http.getNumInFlight() == 1)
+
+local ticksWaited = 0
+local function waitForAsyncResponse ()
+	if not asyncDone then
+		ticksWaited = ticksWaited + 1
+		assert(ticksWaited < 600, 'async request timed out')
+		nextTick(waitForAsyncResponse)
+		return
+	end
+
+	assert(asyncResponse)
+	assert(asyncResponse.status >= 200 and asyncResponse.status <= 299)
+	assert(asyncResponse.body:find('Disallow'))
+	assert(http.getNumInFlight() == 0)
+end
+
+nextTick(waitForAsyncResponse)
+
+local downloadPath = 'rs_test_download.txt'
+local downloadResult
+
+http.download('https://github.com/robots.txt', downloadPath, function (res)
+	if res.done then
+		downloadResult = res
+	end
+end)
+
+local downloadTicksWaited = 0
+local function waitForDownload ()
+	if not downloadResult then
+		downloadTicksWaited = downloadTicksWaited + 1
+		assert(downloadTicksWaited < 600, 'download timed out')
+		nextTick(waitForDownload)
+		return
+	end
+
+	assert(not downloadResult.error, downloadResult.error)
+	assert(downloadResult.status >= 200 and downloadResult.status <= 299)
+	assert(downloadResult.received > 0)
+
+	local file = assert(io.open(downloadPath, 'rb'))
+	local contents = file:read('*a')
+	file:close()
+	os.remove(downloadPath)
+
+	assert(#contents == downloadResult.received)
+	assert(contents:find('Disallow'))
+	assert(not io.open(downloadPath .. '.part', 'rb'))
+end
+
+nextTick(waitForDownload)
\ No newline at end of file
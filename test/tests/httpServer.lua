@@ -0,0 +1,112 @@
+local port = 30080
+
+assert(not httpServer.isRunning())
+assert(httpServer.start('127.0.0.1', port))
+assert(httpServer.isRunning())
+
+local origin = 'http://127.0.0.1:' .. port
+
+do
+	local res = assert(http.getSync(origin, '/status', {}))
+	assert(res.status == 200)
+	assert(res.body:find('"luaErrors":'))
+
+	res = assert(http.getSync(origin, '/metrics', {}))
+	assert(res.status == 200)
+	assert(res.body:find('rosaserver_ticks_total'))
+end
+
+do
+	-- The previous request left its connection idle in the pool
+	local before = http.getPoolStats()
+	assert(http.getSync(origin, '/status', {}))
+	local after = http.getPoolStats()
+
+	assert(after.hits == before.hits + 1)
+	assert(after.misses == before.misses)
+	assert(after.idle >= 1)
+	assert(after.active == 0)
+
+	assert(not pcall(http.setPoolLimits, 0, 30))
+end
+
+httpServer.addRoute('GET', '/echo', function (req)
+	assert(req.method == 'GET')
+	assert(req.path == '/echo')
+	return 'echo ' .. req.params.word, 201, 'text/plain'
+end)
+
+local asyncDone = false
+local asyncResponse
+
+http.get(origin, '/echo?word=hello', {}, function (res)
+	asyncDone = true
+	asyncResponse = res
+end)
+
+local startUpload, waitForUpload
+
+local ticksWaited = 0
+local function waitForRouteResponse ()
+	if not asyncDone then
+		ticksWaited = ticksWaited + 1
+		assert(ticksWaited < 600, 'route request timed out')
+		nextTick(waitForRouteResponse)
+		return
+	end
+
+	assert(asyncResponse)
+	assert(asyncResponse.status == 201)
+	assert(asyncResponse.body == 'echo hello')
+
+	httpServer.removeRoute('GET', '/echo')
+	local res = assert(http.getSync(origin, '/echo', {}))
+	assert(res.status == 404)
+
+	startUpload()
+end
+
+local uploadPath = 'rs_test_upload.txt'
+local uploadContents = string.rep('upload ', 20000)
+local uploadResult
+
+function startUpload ()
+	local file = assert(io.open(uploadPath, 'wb'))
+	file:write(uploadContents)
+	file:close()
+
+	httpServer.addRoute('POST', '/upload', function (req)
+		return tostring(req.body == uploadContents)
+	end)
+
+	http.upload(uploadPath, origin .. '/upload', function (res)
+		if res.done then
+			uploadResult = res
+		end
+	end)
+
+	ticksWaited = 0
+	nextTick(waitForUpload)
+end
+
+function waitForUpload ()
+	if not uploadResult then
+		ticksWaited = ticksWaited + 1
+		assert(ticksWaited < 600, 'upload timed out')
+		nextTick(waitForUpload)
+		return
+	end
+
+	os.remove(uploadPath)
+
+	assert(not uploadResult.error, uploadResult.error)
+	assert(uploadResult.status == 200)
+	assert(uploadResult.sent == #uploadContents)
+	assert(uploadResult.total == #uploadContents)
+	assert(uploadResult.body == 'true')
+
+	httpServer.stop()
+	assert(not httpServer.isRunning())
+end
+
+nextTick(waitForRouteResponse)
\ No newline at end of file
@@ -0,0 +1,15 @@
+function double (payload)
+	return tostring(tonumber(payload) * 2)
+end
+
+function fail ()
+	error('expected failure')
+end
+
+function describe (payload)
+	return { payload = payload, length = #payload }
+end
+
+function returnFunction ()
+	return print
+end
\ No newline at end of file
@@ -0,0 +1,81 @@
+assert(not pcall(jobs.pool, 0, 'tests/jobs.jobs.lua'))
+
+local pool = jobs.pool(4, 'tests/jobs.jobs.lua')
+assert(pool:getNumThreads() == 4)
+
+local numJobs = 100
+local results = {}
+local numResults = 0
+local failure
+
+for i = 1, numJobs do
+	pool:submit('double', tostring(i), function (result, err)
+		assert(not err, err)
+		results[i] = tonumber(result)
+		numResults = numResults + 1
+	end)
+end
+
+pool:submit('fail', '', function (result, err)
+	assert(result == nil)
+	failure = err
+end)
+
+local description
+pool:submit('describe', 'hello', function (result, err)
+	assert(not err, err)
+	description = result
+end)
+
+local unserializable
+pool:submit('returnFunction', '', function (result, err)
+	assert(result == nil)
+	unserializable = err
+end)
+
+assert(pool:getNumPending() == numJobs + 3)
+
+-- A pool collected with jobs still pending lets go of their callbacks
+do
+	local callbacks = setmetatable({}, { __mode = 'k' })
+
+	-- In its own function so nothing is left referenced on the stack
+	local function abandonPool ()
+		local abandoned = jobs.pool(1, 'tests/jobs.jobs.lua')
+		for i = 1, 10 do
+			local callback = function () end
+			callbacks[callback] = true
+			abandoned:submit('double', tostring(i), callback)
+		end
+	end
+
+	abandonPool()
+	-- Once to finalize the pool, once more for the callbacks it released
+	collectgarbage()
+	collectgarbage()
+	assert(next(callbacks) == nil, 'Callbacks outlived their pool')
+end
+
+local ticksWaited = 0
+local function waitForJobs ()
+	if pool:getNumPending() > 0 then
+		ticksWaited = ticksWaited + 1
+		assert(ticksWaited < 600, 'jobs timed out')
+		nextTick(waitForJobs)
+		return
+	end
+
+	assert(numResults == numJobs)
+	for i = 1, numJobs do
+		assert(results[i] == i * 2)
+	end
+	assert(failure and failure:find('expected failure'))
+	assert(description.payload == 'hello')
+	assert(description.length == 5)
+	assert(unserializable and unserializable:find('Cannot serialize'))
+
+	pool:stop()
+	assert(not pcall(pool.submit, pool, 'double', '1'))
+end
+
+nextTick(waitForJobs)
\ No newline at end of file
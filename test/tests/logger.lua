@@ -0,0 +1,33 @@
+assert(not pcall(logger.setConsoleLevel, 'loud'))
+assert(not pcall(logger.openFile, '/nonexistent/directory/rs.log'))
+
+local path = os.tmpname()
+local consoleLevel = logger.getConsoleLevel()
+
+-- Only the file gets these
+logger.setConsoleLevel('error')
+logger.openFile(path, { level = 'info', maxBytes = 1024 * 1024, maxFiles = 1 })
+
+logger.debug('not written')
+logger.info('\27[32minfo line\27[0m', 1)
+logger.warning('warning line')
+
+assert(logger.flush(5000))
+logger.closeFile()
+logger.setConsoleLevel(consoleLevel)
+
+local file = assert(io.open(path))
+local contents = file:read('*a')
+file:close()
+os.remove(path)
+
+assert(not contents:find('not written'))
+assert(contents:find('info +info line\t1\n'))
+assert(contents:find('warning +warning line\n'))
+-- Colours are only for the terminal
+assert(not contents:find('\27'))
+
+local stats = logger.getStats()
+assert(stats.capacity > 0)
+assert(stats.written <= stats.logged)
+assert(stats.dropped == stats.droppedByLevel.debug + stats.droppedByLevel.info + stats.droppedByLevel.warning + stats.droppedByLevel.error)
\ No newline at end of file
@@ -0,0 +1,82 @@
+assert(not pcall(luaErrors.configure, { perSecond = -1 }))
+assert(not pcall(luaErrors.configure, { burst = 0 }))
+assert(not pcall(luaErrors.configure, { burst = -1 }))
+assert(not pcall(luaErrors.configure, { disableThreshold = -1 }))
+
+local before = luaErrors.getStats()
+assert(#before.disabledEvents == 0)
+
+-- Printing something whose __tostring errors reports through the usual path
+luaErrors.configure({ burst = 1, perSecond = 0 })
+local broken = setmetatable({}, {
+	__tostring = function ()
+		error('luaErrors test error')
+	end
+})
+for _ = 1, 10 do
+	print(broken)
+end
+luaErrors.configure({ burst = 3, perSecond = 0.2 })
+
+local after = luaErrors.getStats()
+assert(after.errors == before.errors + 10)
+assert(after.printed == before.printed + 1)
+assert(after.suppressed == before.suppressed + 9)
+
+local found = false
+for _, fingerprint in ipairs(luaErrors.getFingerprints()) do
+	if fingerprint.message:find('luaErrors test error') then
+		assert(fingerprint.count == 10)
+		assert(fingerprint.suppressed == 9)
+		found = true
+	end
+end
+assert(found)
+
+-- Nothing to re-enable
+luaErrors.enableEvent('Logic')
+
+-- Errors in one event switch off only that event, until it's re-enabled
+do
+	luaErrors.configure({ disableThreshold = 3, disableWindowSeconds = 60 })
+
+	local runHook = hook.run
+	local numCreates = 0
+	local numPostCreates = 0
+	function hook.run (event, ...)
+		if event == 'ItemCreate' then
+			numCreates = numCreates + 1
+			error('luaErrors disable test error')
+		elseif event == 'PostItemCreate' then
+			numPostCreates = numPostCreates + 1
+		end
+		return runHook(event, ...)
+	end
+
+	local function createItem ()
+		assert(items.create(1, Vector(), RotMatrix(
+			1, 0, 0,
+			0, 1, 0,
+			0, 0, 1
+		))):remove()
+	end
+
+	for _ = 1, 5 do
+		createItem()
+	end
+
+	local disabledEvents = luaErrors.getStats().disabledEvents
+	assert(#disabledEvents == 1)
+	assert(disabledEvents[1] == 'ItemCreate')
+	assert(numCreates == 3)
+	assert(numPostCreates == 5)
+
+	luaErrors.enableEvent('ItemCreate')
+	assert(#luaErrors.getStats().disabledEvents == 0)
+
+	createItem()
+	assert(numCreates == 4)
+
+	hook.run = runHook
+	luaErrors.configure({ disableThreshold = 0 })
+end
\ No newline at end of file
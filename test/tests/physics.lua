@@ -13,6 +13,36 @@ do
 	assert(ray.fraction == 0.5)
 end
 
+do
+	local trajectory = physics.predictTrajectory(
+		Vector(0, airLevel, 0),
+		Vector(1, 0, 0),
+		0.01,
+		1000
+	)
+
+	assert(trajectory.hit)
+	assert(math.abs(trajectory.pos.y - groundLevel) < 0.01)
+	assert(trajectory.pos.x > 0)
+	assert(trajectory.normal:dist(Vector(0, 1, 0)) == 0)
+	assert(trajectory.count == trajectory.step + 1)
+
+	local samples = ffi.cast('float*', trajectory.samples)
+	assert(samples[1] == airLevel)
+	assert(samples[(trajectory.count - 1) * 3 + 1] == trajectory.pos.y)
+
+	local miss = physics.predictTrajectory(
+		Vector(0, airLevel, 0),
+		Vector(0, 1, 0),
+		0,
+		10
+	)
+
+	assert(not miss.hit)
+	assert(miss.count == 11)
+	assert(miss.pos:dist(Vector(0, airLevel + 10, 0)) == 0)
+end
+
 nextTick(function ()
 	do
 		local bot = players.createBot()
@@ -38,6 +68,30 @@ nextTick(function ()
 			assert(ray.fraction <= 0.5)
 			assert(ray.bone == 5)
 
+			man:teleport(Vector(0, airLevel + 10, 0))
+
+			local missed = physics.lineIntersectHuman(
+				man,
+				Vector(-10, airLevel, 0),
+				Vector(10, airLevel, 0)
+			)
+			assert(not missed.hit)
+
+			local rewound = physics.lineIntersectHumanAt(
+				man,
+				Vector(-10, airLevel, 0),
+				Vector(10, airLevel, 0),
+				0
+			)
+			assert(rewound.hit)
+			assert(rewound.bone == ray.bone)
+
+			assert(not physics.lineIntersectHuman(
+				man,
+				Vector(-10, airLevel, 0),
+				Vector(10, airLevel, 0)
+			).hit)
+
 			man:remove()
 			bot:remove()
 		end)
@@ -67,6 +121,25 @@ nextTick(function ()
 			assert(ray.pos.z == 0)
 			assert(ray.normal:dist(Vector(0, 1, 0)) < 0.01)
 
+			local pos = vehicle.pos:clone()
+			-- Listed twice, but only moved once
+			physics.batchTranslate({ vehicle, vehicle }, Vector(0, 5, 0))
+			assert(vehicle.pos:dist(pos + Vector(0, 5, 0)) == 0)
+
+			physics.batchRotate({ vehicle }, vehicle.pos:clone(), RotMatrix(
+				0, 0, 1,
+				0, 1, 0,
+				-1, 0, 0
+			))
+			assert(vehicle.pos:dist(pos + Vector(0, 5, 0)) == 0)
+			-- It started out unrotated
+			assert(vehicle.rot:getForward():dist(Vector(0, 0, 1)) < 0.0001)
+			assert(vehicle.rot:getRight():dist(Vector(-1, 0, 0)) < 0.0001)
+
+			physics.batchAddVelocity({ vehicle }, Vector(1, 0, 0))
+			physics.batchScaleVelocity({ vehicle }, 0)
+			assert(vehicle.vel:length() == 0)
+
 			vehicle:remove()
 		end)
 	end
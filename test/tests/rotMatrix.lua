@@ -32,4 +32,46 @@ assert(rotMatrix.z3 == 1)
 
 local clone = rotMatrix:clone()
 clone.x1 = 0
-assert(rotMatrix.x1 == 1)
\ No newline at end of file
+assert(rotMatrix.x1 == 1)
+
+local function assertNear (a, b)
+	for _, key in ipairs({'x1', 'y1', 'z1', 'x2', 'y2', 'z2', 'x3', 'y3', 'z3'}) do
+		assert(math.abs(a[key] - b[key]) < 0.0001, key)
+	end
+end
+
+local identity = RotMatrix(
+	1, 0, 0,
+	0, 1, 0,
+	0, 0, 1
+)
+
+local euler = RotMatrix(
+	0, 0, 0,
+	0, 0, 0,
+	0, 0, 0
+)
+euler:fromEuler(0, 0, 0)
+assertNear(euler, identity)
+
+local quarterTurn = identity:clone()
+quarterTurn:fromEuler(0, 0, math.pi / 2)
+
+local rotatedInPlace = identity:clone()
+rotatedInPlace:rotateBy(quarterTurn)
+assertNear(rotatedInPlace, quarterTurn)
+
+local skewed = RotMatrix(
+	2, 0, 0,
+	1, 3, 0,
+	0, 0, 0.5
+)
+skewed:orthonormalize()
+assertNear(skewed, identity)
+
+local eighthTurn = identity:clone()
+eighthTurn:fromEuler(0, 0, math.pi / 4)
+
+local interpolated = identity:clone()
+interpolated:slerp(quarterTurn, 0.5)
+assertNear(interpolated, eighthTurn)
\ No newline at end of file
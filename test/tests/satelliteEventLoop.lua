@@ -0,0 +1,29 @@
+local child = assert(ChildProcess.new('tests/satelliteEventLoop.satellite.lua'))
+
+local expected = { 'ok', 'echo a', 'echo b', 'echo c', 'stopped' }
+local received = {}
+local ticks = 0
+
+local function pump ()
+	ticks = ticks + 1
+
+	for _, message in ipairs(child:receiveMessages()) do
+		table.insert(received, message)
+		assert(message == expected[#received], message)
+
+		-- Only sent once the timers are done, so waitMessage times out
+		if message == 'ok' then
+			child:sendMessage('a')
+			child:sendMessage('b')
+			child:sendMessage('c')
+			child:sendMessage('quit')
+		end
+	end
+
+	if #received < #expected then
+		assert(ticks < 600, 'Satellite event loop test timed out')
+		nextTick(pump)
+	end
+end
+
+nextTick(pump)
\ No newline at end of file
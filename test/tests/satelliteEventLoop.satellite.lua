@@ -0,0 +1,39 @@
+local function testTimers ()
+	local start = os.realClock()
+	assert(waitMessage(50) == nil, 'Got a message while waiting')
+	-- The clock only has millisecond precision
+	assert(os.realClock() - start >= 0.049, 'waitMessage returned early')
+
+	local timeouts = 0
+	setTimeout(function ()
+		timeouts = timeouts + 1
+	end, 10)
+
+	local intervals = 0
+	local interval
+	interval = setInterval(function ()
+		intervals = intervals + 1
+		if intervals == 3 then
+			assert(clearTimer(interval))
+		end
+	end, 5)
+
+	sleep(100)
+	assert(timeouts == 1, 'setTimeout fired ' .. timeouts .. ' times')
+	assert(intervals == 3, 'setInterval fired ' .. intervals .. ' times')
+	assert(not clearTimer(interval), 'Interval was cleared twice')
+end
+
+local success, err = pcall(testTimers)
+sendMessage(success and 'ok' or tostring(err))
+
+setMessageHandler(function (message)
+	if message == 'quit' then
+		stopEventLoop()
+	else
+		sendMessage('echo ' .. message)
+	end
+end)
+
+success, err = pcall(runEventLoop)
+sendMessage(success and 'stopped' or tostring(err))
\ No newline at end of file
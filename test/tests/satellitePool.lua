@@ -0,0 +1,73 @@
+local pool = SatellitePool.new(1)
+local maxTicks = 600
+
+-- Polls every tick until check returns true
+local function waitFor (description, check, done)
+	local ticks = 0
+	local function poll ()
+		if check() then
+			done()
+			return
+		end
+
+		ticks = ticks + 1
+		assert(ticks < maxTicks, description .. ' timed out')
+		nextTick(poll)
+	end
+	poll()
+end
+
+local function runJob (source, done)
+	local child = pool:acquireChunk(source)
+	local messages = {}
+
+	waitFor('Satellite job', function ()
+		local status = child:getJobStatus()
+		for _, message in ipairs(child:receiveMessages()) do
+			table.insert(messages, message)
+		end
+		return status ~= nil
+	end, function ()
+		local status = child:getJobStatus()
+		pool:release(child)
+		done(status, messages)
+	end)
+end
+
+local function testCrash ()
+	local child = pool:acquireChunk('os.exit(3)')
+
+	waitFor('Satellite exit', function ()
+		return not child:isRunning()
+	end, function ()
+		pool:release(child)
+
+		local stats = pool:getStats()
+		assert(stats.replaced == 1)
+		assert(stats.spawned == 2)
+		assert(stats.idle == 1)
+
+		runJob("sendMessage('alive')", function (status, messages)
+			assert(status == 0)
+			assert(messages[1] == 'alive')
+		end)
+	end)
+end
+
+runJob("x = 'set' sendMessage(tostring(x))", function (status, messages)
+	assert(status == 0)
+	assert(messages[1] == 'set')
+
+	-- The same satellite, but a fresh state
+	runJob('sendMessage(tostring(x))', function (status, messages)
+		assert(status == 0)
+		assert(messages[1] == 'nil')
+
+		local stats = pool:getStats()
+		assert(stats.spawned == 1)
+		assert(stats.hits == 2)
+		assert(stats.jobs == 2)
+
+		testCrash()
+	end)
+end)
\ No newline at end of file
@@ -0,0 +1,18 @@
+local child = assert(ChildProcess.new('tests/satelliteSockets.satellite.lua'))
+
+local maxTicks = 300
+local ticks = 0
+
+local function try ()
+	ticks = ticks + 1
+
+	local message = child:receiveMessage()
+	if message then
+		assert(message == 'ok', message)
+	else
+		assert(ticks < maxTicks, 'Satellite socket test timed out')
+		nextTick(try)
+	end
+end
+
+nextTick(try)
\ No newline at end of file
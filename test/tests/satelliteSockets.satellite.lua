@@ -0,0 +1,111 @@
+local function echoServer (listener)
+	listener:watch('r', function ()
+		local client = listener:accept()
+		if not client then return end
+
+		client:watch('r', function ()
+			local data = client:receive()
+			if data == '' then
+				client:close()
+			elseif data then
+				client:send(data)
+			end
+		end)
+	end)
+end
+
+local function expectEcho (client, message, done)
+	local received = ''
+
+	client:watch('w', function ()
+		if not client:isConnected() then return end
+		assert(client:send(message) == #message)
+
+		client:watch('r', function ()
+			received = received .. (client:receive() or '')
+			if #received == #message then
+				assert(received == message)
+				client:close()
+				done()
+			end
+		end)
+	end)
+end
+
+local function testTCP ()
+	local listener = Socket.listenTCP('127.0.0.1', 0)
+	assert(listener.isListening)
+	local host, port = listener:getLocalAddress()
+	assert(host == '127.0.0.1')
+	assert(port > 0)
+
+	echoServer(listener)
+	expectEcho(Socket.connectTCP('127.0.0.1', port), 'hello over tcp', function ()
+		listener:close()
+		assert(not listener.isOpen)
+		stopEventLoop()
+	end)
+	runEventLoop()
+end
+
+local function testUDP ()
+	local a = Socket.openUDP('127.0.0.1', 0)
+	local b = Socket.openUDP('127.0.0.1', 0)
+	local _, portA = a:getLocalAddress()
+	local _, portB = b:getLocalAddress()
+
+	assert(b:receiveFrom() == nil)
+
+	b:watch('r', function ()
+		local data, host, port = b:receiveFrom()
+		assert(data == 'hello over udp')
+		assert(host == '127.0.0.1')
+		assert(port == portA)
+		b:close()
+		a:close()
+		stopEventLoop()
+	end)
+
+	assert(a:sendTo('hello over udp', '127.0.0.1', portB))
+	runEventLoop()
+end
+
+local function testUnix ()
+	local path = os.tmpname()
+	os.remove(path)
+
+	local listener = Socket.listenUnix(path)
+	assert(listener:getLocalAddress() == path)
+
+	echoServer(listener)
+	expectEcho(Socket.connectUnix(path), 'hello over unix', function ()
+		listener:close()
+		stopEventLoop()
+	end)
+	runEventLoop()
+
+	-- Closing the listener removes its file
+	assert(not io.open(path))
+end
+
+local function testErrors ()
+	assert(not pcall(Socket.listenTCP, 'localhost', 0))
+	assert(not pcall(Socket.openUDP, '127.0.0.1', 70000))
+	assert(not pcall(Socket.connectUnix, '/nonexistent/socket'))
+
+	local socket = Socket.openUDP('::1', 0)
+	socket:close()
+	assert(not pcall(socket.receiveFrom, socket))
+end
+
+local success, err = pcall(function ()
+	-- Fails the test instead of hanging it
+	setTimeout(function () error('Timed out') end, 5000)
+
+	testTCP()
+	testUDP()
+	testUnix()
+	testErrors()
+end)
+
+sendMessage(success and 'ok' or tostring(err))
\ No newline at end of file
@@ -0,0 +1,66 @@
+local function checkValue (value)
+	assert(value.number == 1.5)
+	assert(value.integer == -42)
+	assert(value.big == 2 ^ 60)
+	assert(value.text == 'hello\0world')
+	assert(value.flag == true)
+	assert(value[1] == 'a' and value[2] == 'b' and value[3] == nil and value[4] == 'd')
+	assert(value.nested.deeper[1] == true)
+	assert(value.pos.class == 'Vector')
+	assert(value.pos == Vector(1, 2, 3))
+	assert(value.rot.class == 'RotMatrix')
+	assert(value.rot.x2 == 4 and value.rot.z3 == 9)
+end
+
+local original = {
+	number = 1.5,
+	integer = -42,
+	big = 2 ^ 60,
+	text = 'hello\0world',
+	flag = true,
+	'a', 'b', nil, 'd',
+	nested = { deeper = { true } },
+	pos = Vector(1, 2, 3),
+	rot = RotMatrix(1, 2, 3, 4, 5, 6, 7, 8, 9),
+}
+
+local encoded = serialize.encode(original)
+assert(type(encoded) == 'string')
+checkValue(serialize.decode(encoded))
+
+assert(serialize.decode(serialize.encode(nil)) == nil)
+assert(serialize.decode(serialize.encode('just a string')) == 'just a string')
+
+do
+	local cyclic = {}
+	cyclic.self = cyclic
+	assert(not pcall(serialize.encode, cyclic))
+
+	local shared = {}
+	local notCyclic = { shared, shared }
+	local decoded = serialize.decode(serialize.encode(notCyclic))
+	assert(type(decoded[1]) == 'table' and type(decoded[2]) == 'table')
+end
+
+assert(not pcall(serialize.encode, { print }))
+assert(not pcall(serialize.decode, encoded:sub(1, -2)))
+assert(not pcall(serialize.decode, ''))
+
+local worker = assert(Worker.new('tests/serialize.worker.lua'))
+assert(worker:sendValue(original))
+
+local ticks = 0
+local function waitForEcho ()
+	local value = worker:receiveValue()
+	if not value then
+		ticks = ticks + 1
+		assert(ticks < 60, 'worker never echoed the value')
+		nextTick(waitForEcho)
+		return
+	end
+
+	checkValue(value)
+	worker:stop()
+end
+
+nextTick(waitForEcho)
\ No newline at end of file
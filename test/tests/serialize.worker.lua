@@ -0,0 +1,4 @@
+local value = receiveValue(5000)
+if value then
+	sendValue(value)
+end
\ No newline at end of file
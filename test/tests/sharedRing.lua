@@ -0,0 +1,50 @@
+-- The smallest ring, so the messages wrap around its end many times
+local child = assert(ChildProcess.new('tests/sharedRing.satellite.lua', {
+	ringSize = 4096
+}))
+
+assert(not pcall(child.sendMessage, child, string.rep('x', 4096)))
+
+local numMessages = 300
+-- Neither ring can fill up while the other side waits to write
+local maxOutstandingBytes = 3000
+
+-- Sizes that don't divide the ring, so messages straddle its end
+local function makeMessage (index)
+	local fill = string.char(65 + index % 26)
+	return index .. ':' .. string.rep(fill, index * 37 % 700)
+end
+
+local sent = 0
+local received = 0
+local outstandingBytes = 0
+local ticks = 0
+
+local function pump ()
+	ticks = ticks + 1
+	assert(ticks < 600, 'Shared ring echo timed out')
+
+	for _, message in ipairs(child:receiveMessages()) do
+		received = received + 1
+		local expected = makeMessage(received)
+		assert(message == expected, 'Message ' .. received .. ' damaged or out of order')
+		outstandingBytes = outstandingBytes - #expected - 4
+	end
+
+	while sent < numMessages do
+		local message = makeMessage(sent + 1)
+		if outstandingBytes + #message + 4 > maxOutstandingBytes then break end
+
+		child:sendMessage(message)
+		sent = sent + 1
+		outstandingBytes = outstandingBytes + #message + 4
+	end
+
+	if received < numMessages then
+		nextTick(pump)
+	else
+		child:sendMessage('quit')
+	end
+end
+
+pump()
\ No newline at end of file
@@ -0,0 +1,5 @@
+while true do
+	local message = waitMessage()
+	if message == 'quit' then break end
+	sendMessage(message)
+end
\ No newline at end of file
@@ -0,0 +1,55 @@
+local tbl = SharedTable.get('tests.sharedTable')
+
+assert(tbl:get('missing') == nil)
+
+tbl:set('name', 'RosaServer')
+tbl:set(1, true)
+tbl:set('binary', '\0\1\2')
+assert(tbl:get('name') == 'RosaServer')
+assert(tbl:get(1) == true)
+assert(tbl:get('1') == nil)
+assert(tbl:get('binary') == '\0\1\2')
+assert(tbl:getSize() == 3)
+
+assert(not pcall(tbl.set, tbl, {}, 1))
+assert(not pcall(tbl.set, tbl, 'table', {}))
+
+assert(tbl:increment('count') == 1)
+assert(tbl:increment('count', 4) == 5)
+assert(not pcall(tbl.increment, tbl, 'name'))
+
+assert(not tbl:compareAndSet('count', 4, 10))
+assert(tbl:compareAndSet('count', 5, 10))
+assert(tbl:get('count') == 10)
+assert(tbl:compareAndSet('new', nil, 'value'))
+assert(not tbl:compareAndSet('new', nil, 'other'))
+
+assert(tbl:delete('binary'))
+assert(not tbl:delete('binary'))
+tbl:set(1, nil)
+assert(tbl:get(1) == nil)
+
+-- The same table by name
+assert(SharedTable.get('tests.sharedTable'):get('name') == 'RosaServer')
+
+local worker = assert(Worker.new('tests/sharedTable.worker.lua'))
+
+local maxTicks = 100
+local ticks = 0
+
+local function waitForWorker ()
+	ticks = ticks + 1
+
+	local message = worker:receiveMessage()
+	if message then
+		assert(message == 'done')
+		assert(tbl:get('count') == 110)
+		assert(tbl:get('fromWorker') == 'hello')
+		worker:stop()
+	else
+		assert(ticks < maxTicks)
+		nextTick(waitForWorker)
+	end
+end
+
+nextTick(waitForWorker)
\ No newline at end of file
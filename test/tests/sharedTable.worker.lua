@@ -0,0 +1,8 @@
+local tbl = SharedTable.get('tests.sharedTable')
+
+for _ = 1, 100 do
+	tbl:increment('count')
+end
+
+tbl:set('fromWorker', 'hello')
+sendMessage('done')
\ No newline at end of file
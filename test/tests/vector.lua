@@ -44,4 +44,25 @@ local ninetyDegreesClockwise = RotMatrix(
 	-1, 0, 0
 )
 local rotated = vector * ninetyDegreesClockwise
-assert(rotated:dist(Vector(3, 2, -1)) == 0)
\ No newline at end of file
+assert(rotated:dist(Vector(3, 2, -1)) == 0)
+
+local crossed = Vector(1, 2, 3)
+crossed:cross(Vector(4, 5, 6))
+assert(crossed:dist(Vector(-3, 6, -3)) == 0)
+
+local accumulated = Vector(1, 1, 1)
+accumulated:addScaled(Vector(1, 2, 3), 2)
+assert(accumulated:dist(Vector(3, 5, 7)) == 0)
+
+local lerped = Vector(0, 0, 0)
+lerped:lerpTo(Vector(10, 20, 30), 0.5)
+assert(lerped:dist(Vector(5, 10, 15)) == 0)
+
+local rotatedInPlace = vector:clone()
+rotatedInPlace:rotateBy(ninetyDegreesClockwise)
+assert(rotatedInPlace:dist(rotated) == 0)
+
+local transformed = Vector()
+vector:transformInto(ninetyDegreesClockwise, transformed)
+assert(transformed:dist(rotated) == 0)
+assert(vector:dist(Vector(1, 2, 3)) == 0)
\ No newline at end of file
@@ -0,0 +1,158 @@
+assert(not pcall(webhook.enqueue, 'not a url', 'x'))
+
+do
+	local url = 'http://127.0.0.1:1/never'
+	webhook.configure(url, { flushMs = 1000000000, maxQueuedBytes = 8 })
+
+	assert(webhook.enqueue(url, '12345'))
+	assert(not webhook.enqueue(url, '6789'))
+
+	local stats = webhook.getStats(url)
+	assert(stats.queued == 1)
+	assert(stats.queuedBytes == 5)
+	assert(stats.dropped == 1)
+end
+
+-- A Retry-After too big to represent is capped, and one that isn't a usable
+-- number falls back to the usual backoff. An endpoint that never answers
+-- doesn't hold up the rest.
+do
+	local child = assert(ChildProcess.new('tests/webhook.satellite.lua'))
+	local baseURL, hugeURL, infURL
+	local ticks = 0
+
+	local function waitForOther ()
+		ticks = ticks + 1
+		assert(ticks < 600, 'webhook was held up by another endpoint')
+
+		local ok = webhook.getStats(baseURL .. '/ok')
+		if ok.sent < 1 then
+			nextTick(waitForOther)
+			return
+		end
+
+		local hang = webhook.getStats(baseURL .. '/hang')
+		assert(hang.queued == 1)
+		assert(hang.sent == 0)
+		assert(hang.failed == 0)
+
+		child:sendMessage('quit')
+	end
+
+	local function waitForHang ()
+		ticks = ticks + 1
+		assert(ticks < 600, 'webhook never reached the hanging endpoint')
+
+		local message = child:receiveMessage()
+		if not message then
+			nextTick(waitForHang)
+			return
+		end
+		assert(message == 'hanging', message)
+
+		webhook.configure(baseURL .. '/ok', { flushMs = 0 })
+		assert(webhook.enqueue(baseURL .. '/ok', '1'))
+
+		ticks = 0
+		nextTick(waitForOther)
+	end
+
+	local function waitForRetries ()
+		ticks = ticks + 1
+		assert(ticks < 600, 'webhook retries timed out')
+
+		local huge = webhook.getStats(hugeURL)
+		local inf = webhook.getStats(infURL)
+		if huge.retries < 1 or inf.failed < 1 then
+			nextTick(waitForRetries)
+			return
+		end
+
+		-- Still waiting out the capped delay
+		assert(huge.retries == 1)
+		assert(huge.queued == 1)
+		assert(huge.failed == 0)
+
+		assert(inf.retries == 2)
+		assert(inf.queued == 0)
+
+		webhook.configure(baseURL .. '/hang', { flushMs = 0, maxRetries = 0 })
+		assert(webhook.enqueue(baseURL .. '/hang', '1'))
+
+		ticks = 0
+		nextTick(waitForHang)
+	end
+
+	local function waitForPort ()
+		ticks = ticks + 1
+		assert(ticks < 600, 'webhook satellite never started')
+
+		local port = child:receiveMessage()
+		if not port then
+			nextTick(waitForPort)
+			return
+		end
+
+		baseURL = 'http://127.0.0.1:' .. port
+		hugeURL = baseURL .. '/huge'
+		infURL = baseURL .. '/inf'
+		webhook.configure(hugeURL, { flushMs = 0 })
+		webhook.configure(infURL, { flushMs = 0, maxRetries = 2 })
+		assert(webhook.enqueue(hugeURL, '1'))
+		assert(webhook.enqueue(infURL, '1'))
+
+		ticks = 0
+		nextTick(waitForRetries)
+	end
+
+	nextTick(waitForPort)
+end
+
+local port = 30081
+local url = 'http://127.0.0.1:' .. port .. '/hook'
+local bodies = {}
+
+local ticksWaited = 0
+local function waitForDelivery ()
+	local stats = webhook.getStats(url)
+	if stats.sent < 4 then
+		ticksWaited = ticksWaited + 1
+		assert(ticksWaited < 600, 'webhook delivery timed out')
+		nextTick(waitForDelivery)
+		return
+	end
+
+	assert(#bodies == 2)
+	assert(bodies[1] == '[1,2,3]')
+	assert(bodies[2] == '[4]')
+	assert(stats.queued == 0)
+	assert(stats.failed == 0)
+
+	httpServer.stop()
+end
+
+-- The server may still be in use by another test
+local function startServer ()
+	if httpServer.isRunning() then
+		ticksWaited = ticksWaited + 1
+		assert(ticksWaited < 600, 'server never became free')
+		nextTick(startServer)
+		return
+	end
+
+	assert(httpServer.start('127.0.0.1', port))
+	httpServer.addRoute('POST', '/hook', function (req)
+		table.insert(bodies, req.body)
+		return '', 204
+	end)
+
+	webhook.configure(url, { maxBatchMessages = 3, flushMs = 50 })
+	for i = 1, 4 do
+		assert(webhook.enqueue(url, tostring(i)))
+	end
+
+	ticksWaited = 0
+	nextTick(waitForDelivery)
+end
+
+startServer()
\ No newline at end of file
@@ -0,0 +1,61 @@
+-- /ok succeeds, /hang never answers, and anything else gets a 429 whose
+-- Retry-After depends on the path
+local retryAfters = {
+	['/huge'] = '99999999999',
+	['/inf'] = '1e400'
+}
+
+local function respond (client, request)
+	local path = request:match('^%u+ (%S+)')
+	if path == '/hang' then
+		sendMessage('hanging')
+		return
+	end
+
+	local status = '429 Too Many Requests\r\nRetry-After: ' ..
+		(retryAfters[path] or '0')
+	if path == '/ok' then
+		status = '204 No Content'
+	end
+
+	client:send(
+		'HTTP/1.1 ' .. status .. '\r\n' ..
+		'Content-Length: 0\r\n' ..
+		'Connection: close\r\n\r\n'
+	)
+	client:close()
+end
+
+local listener = Socket.listenTCP('127.0.0.1', 0)
+listener:watch('r', function ()
+	local client = listener:accept()
+	if not client then return end
+
+	local received = ''
+	client:watch('r', function ()
+		local data = client:receive()
+		if data == '' then
+			client:close()
+			return
+		end
+		received = received .. (data or '')
+
+		-- Only answers once the whole body is in, so closing doesn't reset
+		local headerEnd = received:find('\r\n\r\n', 1, true)
+		if not headerEnd then return end
+		local length = tonumber(received:match('[Cc]ontent%-[Ll]ength: (%d+)')) or 0
+		if #received >= headerEnd + 3 + length then
+			respond(client, received)
+		end
+	end)
+end)
+
+local _, port = listener:getLocalAddress()
+sendMessage(tostring(port))
+
+setMessageHandler(function (message)
+	if message == 'quit' then
+		stopEventLoop()
+	end
+end)
+runEventLoop()
\ No newline at end of file
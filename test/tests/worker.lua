@@ -1,7 +1,13 @@
 local worker = assert(Worker.new('tests/worker.worker.lua'))
 
 assert(not worker:receiveMessage())
-worker:sendMessage('hi')
+assert(worker:sendMessage('hi'))
+
+assert(not pcall(Worker.new, 'tests/worker.worker.lua', { name = 'a name that is far too long' }))
+assert(not pcall(Worker.new, 'tests/worker.worker.lua', { cpus = {} }))
+
+local named = Worker.new('tests/worker.worker.lua', { name = 'rs-test', cpus = { 0 } })
+named:stop()
 
 local maxTicks = 10
 local ticks = 0
@@ -12,6 +18,18 @@ local function try ()
 	local message = worker:receiveMessage()
 	if message then
 		assert(message == 'hello')
+
+		local stats = worker:getStats()
+		assert(stats.messagesSent == 1)
+		assert(stats.messagesReceived == 1)
+		assert(stats.toWorkerQueued == 0)
+		assert(stats.fromWorkerQueued == 0)
+		assert(stats.queueCapacity > 0)
+		assert(stats.sentPerSecond >= 0)
+		assert(stats.cpuSeconds >= 0)
+
+		worker:stop()
+		assert(not worker:sendMessage('hi'))
 	else
 		assert(ticks < maxTicks)
 		nextTick(try)
@@ -1,7 +1,4 @@
-while true do
-	if receiveMessage() == 'hi' then
-		sendMessage('hello')
-		break
-	end
-	sleep(8)
+local message = receiveMessage(5000)
+if message == 'hi' then
+	sendMessage('hello')
 end
\ No newline at end of file
@@ -0,0 +1,65 @@
+local item = assert(items.create(
+	1,
+	Vector(10, 20, 30),
+	RotMatrix(
+		1, 0, 0,
+		0, 1, 0,
+		0, 0, 1
+	)
+))
+
+-- Nothing is published until it's first asked for
+world.getSnapshot()
+
+local worker = assert(Worker.new('tests/world.worker.lua'))
+
+local waitForWorker
+
+local function checkSnapshot ()
+	local snapshot = world.getSnapshot()
+	if not snapshot then
+		nextTick(checkSnapshot)
+		return
+	end
+
+	assert(snapshot.tick > 0)
+
+	local found
+	for _, entry in ipairs(snapshot:getItems()) do
+		if entry.index == item.index then
+			found = entry
+		end
+	end
+	assert(found, 'item missing from snapshot')
+	assert(found.type == 1)
+	assert(found.pos.class == 'Vector')
+
+	assert(type(snapshot:getHumans()) == 'table')
+	assert(type(snapshot:getPlayers()) == 'table')
+	assert(type(snapshot:getVehicles()) == 'table')
+
+	snapshot:release()
+	assert(not pcall(snapshot.getItems, snapshot))
+
+	waitForWorker()
+end
+
+local ticks = 0
+function waitForWorker ()
+	local message = worker:receiveMessage()
+	if not message then
+		ticks = ticks + 1
+		assert(ticks < 60, 'worker never read a snapshot')
+		nextTick(waitForWorker)
+		return
+	end
+
+	local tick, numItems = message:match('^(%d+) (%d+)$')
+	assert(tonumber(tick) > 0)
+	assert(tonumber(numItems) >= 1)
+
+	worker:stop()
+	item:remove()
+end
+
+nextTick(checkSnapshot)
\ No newline at end of file
@@ -0,0 +1,13 @@
+local snapshot
+repeat
+	snapshot = world.getSnapshot()
+	if not snapshot and sleep(5) then
+		return
+	end
+until snapshot
+
+local tick = snapshot.tick
+local numItems = #snapshot:getItems()
+snapshot:release()
+
+sendMessage(tick .. ' ' .. numItems)
\ No newline at end of file